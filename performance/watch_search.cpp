@@ -0,0 +1,77 @@
+// Microbenchmark of the replacement-watch search kernels (src/watch_search.h).
+// For each clause length it searches many random clauses, once with the first
+// non-false literal at a random position and once with it last, and reports
+// ns per search for each kernel. Build with 'make bench'.
+#include "watch_search.h"
+#include <chrono>
+#include <iomanip>
+
+static const int Num_lits = 1 << 16;
+static const int Num_clauses = 1 << 12;
+
+struct Workload {
+	vector<Lit> lits; // Num_clauses clauses of 'len' literals each
+	vector<int> target; // clause => the index the search must return
+	int len;
+};
+
+static Workload make_workload(int len, bool at_end, const vector<signed char> &vals, mt19937 &rng)
+{
+	vector<Lit> false_lits, other_lits;
+	for (Lit l = 1; l <= Num_lits; ++l)
+		(vals[l] < 0 ? false_lits : other_lits).push_back(l);
+	Workload w;
+	w.len = len;
+	for (int c = 0; c < Num_clauses; ++c)
+	{
+		const int t = at_end ? len - 1 : static_cast<int>(rng() % len);
+		for (int i = 0; i < len; ++i)
+			w.lits.push_back(i == t ? other_lits[rng() % other_lits.size()] : false_lits[rng() % false_lits.size()]);
+		w.target.push_back(t);
+	}
+	return w;
+}
+
+// Returns ns per search, or -1 if the kernel got a result wrong
+static double time_kernel(WatchSearch search, const Workload &w, const vector<signed char> &vals, int reps)
+{
+	long checksum = 0;
+	auto start = chrono::steady_clock::now();
+	for (int r = 0; r < reps; ++r)
+		for (int c = 0; c < Num_clauses; ++c)
+			checksum += search(w.lits.data() + c * w.len, 0, w.len, vals.data(), 0);
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+	for (int c = 0; c < Num_clauses; ++c)
+		if (search(w.lits.data() + c * w.len, 0, w.len, vals.data(), 0) != w.target[c])
+			return -1;
+	return checksum < 0 ? -1 : ns / (static_cast<double>(reps) * Num_clauses);
+}
+
+int main()
+{
+	mt19937 rng(1);
+	vector<signed char> vals(Num_lits + 1 + Vals_padding, 0);
+	for (Lit l = 1; l <= Num_lits; ++l)
+		vals[l] = rng() % 4 ? -1 : (rng() % 2 ? 1 : 0); // mostly false, as during BCP
+	cout << "kernel chosen by CPUID: " << watch_search_kernel() << endl;
+	bool ok = true;
+	for (int at_end = 0; at_end <= 1; ++at_end)
+	{
+		cout << (at_end ? "non-false literal last:" : "non-false literal at a random position:") << endl;
+		cout << "  len   scalar ns   avx2 ns   speedup" << endl;
+		for (int len : {4, 8, 16, 32, 64, 128, 256})
+		{
+			Workload w = make_workload(len, at_end, vals, rng);
+			const int reps = max(1, 4096 / len);
+			double scalar = time_kernel(watch_search_scalar, w, vals, reps);
+			double simd = time_kernel(find_not_false, w, vals, reps);
+			if (scalar < 0 || simd < 0)
+				ok = false;
+			cout << setw(5) << len << setw(12) << fixed << setprecision(2) << scalar << setw(10) << simd
+				 << setw(10) << scalar / simd << endl;
+		}
+	}
+	if (!ok)
+		cout << "MISMATCH: a kernel returned a wrong index" << endl;
+	return ok ? 0 : 1;
+}
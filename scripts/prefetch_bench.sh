@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# This script measures the gain of software prefetching in BCP
+# Builds the release binary without (PREFETCH=0) and with prefetching, runs both
+# on the largest CNF files in tests/hard_cnf_instances and prints their times.
+# Prefetching does not change the search, so both binaries do the same work.
+
+# Check if WORKDIR is set
+if [[ -z "$WORKDIR" ]]; then
+    echo "Error: WORKDIR is not defined. Please set WORKDIR before running the script."
+    exit 1
+fi
+
+# Argments check
+if [ "$#" -gt 2 ]; then
+    echo "Usage: $0 [num_instances] [timeout_in_seconds]"
+    exit 1
+fi
+
+NUM_INSTANCES=${1:-8}
+TIMEOUT_IN_SEC=${2:-60}
+INPUT_DIR="$WORKDIR/tests/hard_cnf_instances"
+BIN_DIR=$(mktemp -d)
+
+# Build both binaries
+make -C "$WORKDIR" release PREFETCH=0 > /dev/null 2>&1 || exit 1
+cp "$WORKDIR/build/release/edusat" "$BIN_DIR/edusat-noprefetch"
+make -C "$WORKDIR" release > /dev/null 2>&1 || exit 1
+cp "$WORKDIR/build/release/edusat" "$BIN_DIR/edusat-prefetch"
+
+# Runs $1 on $2 and prints its wall time in seconds, or TIMEOUT
+run_timed() {
+    local start end
+    start=$(date +%s.%N)
+    timeout $TIMEOUT_IN_SEC "$1" "$2" > /dev/null
+    if [[ $? -eq 124 ]]; then
+        echo "TIMEOUT"
+        return
+    fi
+    end=$(date +%s.%N)
+    awk "BEGIN {printf \"%.2f\", $end - $start}"
+}
+
+cd "$BIN_DIR"
+TOTAL_OFF=0
+TOTAL_ON=0
+printf "%-55s %12s %12s\n" "instance (largest first)" "no prefetch" "prefetch"
+for file in $(ls -S "$INPUT_DIR"/*.cnf | head -n "$NUM_INSTANCES"); do
+    OFF=$(run_timed "$BIN_DIR/edusat-noprefetch" "$file")
+    ON=$(run_timed "$BIN_DIR/edusat-prefetch" "$file")
+    printf "%-55s %12s %12s\n" "$(basename "$file")" "$OFF" "$ON"
+    if [[ $OFF != "TIMEOUT" && $ON != "TIMEOUT" ]]; then
+        TOTAL_OFF=$(awk "BEGIN {print $TOTAL_OFF + $OFF}")
+        TOTAL_ON=$(awk "BEGIN {print $TOTAL_ON + $ON}")
+    fi
+done
+echo "==================== Summary - prefetch_bench.sh ===================="
+echo "Total time of the instances solved by both: $TOTAL_OFF s without prefetching, $TOTAL_ON s with it"
+echo "===================================================================="
+
+rm -rf "$BIN_DIR"
@@ -33,6 +33,111 @@ namespace BVA
         return os;
     }
 
+    ClauseArena::ClauseArena() : top(nullptr), limit(nullptr)
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ClauseArena::~ClauseArena() { clear(); }
+
+    unsigned ClauseArena::size_class(unsigned size)
+    {
+        assert(size);
+        if (size <= exact_classes)
+            return size - 1;
+        unsigned cls = exact_classes - 1, cap = exact_classes;
+        while (cap < size)
+            cap *= 2, cls++;
+        return cls;
+    }
+
+    unsigned ClauseArena::class_capacity(unsigned cls)
+    {
+        if (cls < exact_classes)
+            return cls + 1;
+        return exact_classes << (cls - exact_classes + 1);
+    }
+
+    size_t ClauseArena::bytes(unsigned cap)
+    {
+        // Keep every clause pointer aligned, as released clauses store the
+        // free list link in their first bytes.
+        size_t res = offsetof(Clause, lits) + cap * sizeof(int);
+        const size_t align = alignof(Clause *);
+        return (res + align - 1) & ~(align - 1);
+    }
+
+    char *ClauseArena::bump(size_t n)
+    {
+        if (!top || (size_t)(limit - top) < n)
+        {
+            size_t slab_bytes = max(n, min_slab_bytes);
+            char *slab = new char[slab_bytes];
+            slabs.push_back(slab);
+            top = slab, limit = slab + slab_bytes;
+            stats.bytes += slab_bytes;
+        }
+        char *res = top;
+        top += n;
+        return res;
+    }
+
+    Clause *ClauseArena::allocate(int size)
+    {
+        assert(size > 0);
+        const unsigned cls = size_class(size);
+        Clause *c;
+        if (cls < free_lists.size() && free_lists[cls])
+        {
+            c = free_lists[cls];
+            memcpy(&free_lists[cls], c, sizeof(Clause *));
+            stats.recycled++;
+        }
+        else
+            c = reinterpret_cast<Clause *>(bump(bytes(class_capacity(cls))));
+        c->cap = class_capacity(cls);
+        c->sz = size;
+        c->active = true;
+        stats.allocated++;
+        return c;
+    }
+
+    Clause *ClauseArena::allocate(initializer_list<int> lits)
+    {
+        Clause *c = allocate((int)lits.size());
+        copy(lits.begin(), lits.end(), c->begin());
+        return c;
+    }
+
+    Clause *ClauseArena::allocate(const vector<int> &lits)
+    {
+        Clause *c = allocate((int)lits.size());
+        copy(lits.begin(), lits.end(), c->begin());
+        return c;
+    }
+
+    void ClauseArena::release(Clause *c)
+    {
+        assert(c);
+        const unsigned cls = size_class(c->cap);
+        assert(class_capacity(cls) == c->cap);
+        if (cls >= free_lists.size())
+            free_lists.resize(cls + 1, nullptr);
+        memcpy((void *)c, &free_lists[cls], sizeof(Clause *));
+        free_lists[cls] = c;
+        stats.released++;
+    }
+
+    void ClauseArena::clear()
+    {
+        for (char *slab : slabs)
+            delete[] slab;
+        slabs.clear();
+        free_lists.clear();
+        top = limit = nullptr;
+        stats.bytes = 0;
+    }
+
     int AutomatedReencoder::vidx(int lit) const
     {
         int idx;
@@ -67,6 +172,8 @@ namespace BVA
 
         marks.resize(2 * new_size_vars);
         seen.resize(2 * new_size_vars);
+        hop1.resize(new_size_vars + 1);
+        hop2.resize(new_size_vars + 1);
 
         assert(idx < new_size_vars);
         size_vars = new_size_vars;
@@ -96,7 +203,7 @@ namespace BVA
         assert(!marked(lit));
     }
 
-    bool AutomatedReencoder::tautological(const Clause &c)
+    bool AutomatedReencoder::tautological(const vector<int> &c)
     {
         imported_clause.clear();
         unsigned idx;
@@ -142,15 +249,23 @@ namespace BVA
         return nullptr;
     }
 
-    bool AutomatedReencoder::existsInLitMap(const LitMap &P, int l, Clause &c)
+    Occs &AutomatedReencoder::matched(int lit)
     {
-        auto it = P.find(l);
-        if (it == P.end())
-            return false;
-        for (const auto &d : it->second)
-            if (clausesAreIdentical(*d, c))
-                return true;
-        return false;
+        assert(vlit(lit) < P_cls.size());
+        return P_cls[vlit(lit)];
+    }
+
+    const Occs &AutomatedReencoder::matched(int lit) const
+    {
+        assert(vlit(lit) < P_cls.size());
+        return P_cls[vlit(lit)];
+    }
+
+    void AutomatedReencoder::clearMatched()
+    {
+        for (int lit : P_touched)
+            matched(lit).clear();
+        P_touched.clear();
     }
 
     // Returns the last least occuring literal in c that is not 'other'.
@@ -161,6 +276,7 @@ namespace BVA
         if (c->size() == 1)
             return 0;
         int res_lit, res_occCount = INT_MAX;
+        stats.steps += c->size();
         for (int lit : *c)
         {
             if (other == lit)
@@ -176,45 +292,124 @@ namespace BVA
         return res_lit;
     }
 
-    // Returns a literal l in c that is not in d in case both clauses differ only
-    // in one lit. Otherwise, returns 0.
-    int AutomatedReencoder::getSingleLiteralDifference(Clause *c, Clause *d)
+    // Expects the literals of the current clause c, except 'l', to be marked.
+    // Returns the literal l_ such that d = (c \ {l}) U {l_}, where l_ != l.
+    // Otherwise, returns 0.
+    int AutomatedReencoder::getReplacingLiteral(const Clause *d, int size, int l)
     {
-        assert(c && d);
-        if (c->size() != d->size())
+        assert(d);
+        stats.steps++;
+        if (d->size() != size)
             return 0;
+        int diff_lit = 0;
         for (int lit : *d)
-        {
-            assert(!marked(lit));
-            mark(lit);
-        }
-        int diffs = 0, diff_lit = 0;
-        for (int lit : *c)
         {
             if (marked(lit) > 0)
                 continue;
-            diffs++;
+            if (diff_lit)
+                return 0;
             diff_lit = lit;
         }
-        for (int lit : *d)
-            unmark(lit);
-        return diffs > 1 ? 0 : diff_lit;
+        return diff_lit == l ? 0 : diff_lit;
     }
 
-    bool AutomatedReencoder::reductionIncreases(const LitMap &P_cls, const set<int> &M_lit, const vector<Clause *> &M_cls, int lit) const
+    bool AutomatedReencoder::reductionIncreases(int lit) const
     {
-        const int old_red = M_lit.size() * M_cls.size() - M_lit.size() - M_cls.size();
+        const int lits = M_lit.size(), clauses = M_cls.size();
+        const int old_red = lits * clauses - lits - clauses;
 
-        auto M_litt(M_lit);
-        M_litt.insert(lit);
+        // M_lit is sorted, so membership is a binary search
+        const int new_lits = lits + !binary_search(M_lit.begin(), M_lit.end(), lit);
         // Count only relevant clauses in P_cls
-        int P_relevant = P_cls.at(lit).size();
+        const int P_relevant = matched(lit).size();
         assert(P_relevant);
-        const int new_red = (M_litt.size()) * P_relevant - M_litt.size() - P_relevant;
+        const int new_red = new_lits * P_relevant - new_lits - P_relevant;
         DEBUG_MSG(cout << "new_red = " << new_red << " old_red " << old_red << endl);
         return new_red > old_red && new_red > 0;
     }
 
+    void AutomatedReencoder::computeTwoHops(int lit)
+    {
+        for (int v : hop1_touched)
+            hop1[v] = 0;
+        for (int v : hop2_touched)
+            hop2[v] = 0;
+        hop1_touched.clear();
+        hop2_touched.clear();
+
+        // Two variables are adjacent once for every clause containing both
+        const int v = vidx(lit);
+        for (int l : {v, -v})
+            for (const Clause *c : occs(l))
+                for (int other : *c)
+                {
+                    stats.steps++;
+                    int u = vidx(other);
+                    if (u == v)
+                        continue;
+                    if (!hop1[u]++)
+                        hop1_touched.push_back(u);
+                }
+        for (int u : hop1_touched)
+            for (int l : {u, -u})
+                for (const Clause *c : occs(l))
+                    for (int other : *c)
+                    {
+                        stats.steps++;
+                        int w = vidx(other);
+                        if (w == u)
+                            continue;
+                        if (!hop2[w])
+                            hop2_touched.push_back(w);
+                        hop2[w] += hop1[u];
+                    }
+        hops_lit = lit;
+    }
+
+    // Returns the number of paths of length 3 between the variables of 'lit'
+    // and 'other' in the variable incidence graph, i.e. (A^3)[lit][other].
+    int64_t AutomatedReencoder::threeHops(int lit, int other)
+    {
+        if (hops_lit != lit)
+            computeTwoHops(lit);
+        const int v = vidx(other);
+        int64_t res = 0;
+        for (int l : {v, -v})
+        {
+            stats.steps += occs(l).size();
+            for (const Clause *c : occs(l))
+                for (int w : *c)
+                    if (vidx(w) != v)
+                        res += hop2[vidx(w)];
+        }
+        return res;
+    }
+
+    // Decides whether 'cand' should replace 'best' as l_max when both match
+    // the same number of clauses. 'best_hops' caches threeHops(lit, best),
+    // -1 if not computed yet. Remaining ties go to the smaller variable, then
+    // to the positive literal, so the choice does not depend on the order of P.
+    bool AutomatedReencoder::breaksTie(int lit, int best, int cand, int64_t &best_hops)
+    {
+        if (tie_breaking == TieBreaking::NONE)
+            return false;
+        assert(tie_breaking == TieBreaking::THREE_HOP);
+        stats.ties++;
+        if (best_hops < 0)
+            best_hops = threeHops(lit, best);
+        const int64_t cand_hops = threeHops(lit, cand);
+        if (cand_hops != best_hops)
+        {
+            if (cand_hops < best_hops)
+                return false;
+            best_hops = cand_hops;
+            return true;
+        }
+        if (abs(cand) != abs(best) ? abs(cand) > abs(best) : cand < best)
+            return false;
+        return true;
+    }
+
     int AutomatedReencoder::introduceNewVariable()
     {
         int x = ++max_var;
@@ -222,12 +417,34 @@ namespace BVA
             enlarge_marks(x);
         for (int i = otab.size() - 1; i < 2 * size_vars + 2; i++)
             otab.push_back(Occs());
+        P_cls.resize(otab.size());
         stats.aux_vars++;
         return x;
     }
 
+    // (Re)builds the occurrence lists of all clauses. Returns the # of literals.
+    int64_t AutomatedReencoder::connectOccurrences()
+    {
+        assert(max_var <= size_vars);
+        for (Occs &os : otab)
+            os.clear();
+        otab.resize(2 * size_vars + 2, Occs());
+        int64_t res = 0;
+        for (Clause *c : cnf)
+        {
+            assert(c);
+            for (int lit : *c)
+                occs(lit).push_back(c);
+            res += c->size();
+        }
+        return res;
+    }
+
     bool AutomatedReencoder::clausesAreIdentical(const Clause &c, const Clause &d)
     {
+        // Clauses of different sizes may share a hash bucket
+        if (c.size() != d.size())
+            return false;
         bool identical = true;
         for (int lit : c)
             mark(lit);
@@ -248,7 +465,8 @@ namespace BVA
     {
         assert(c);
         if (proof)
-            proof->notify_added_clause(c->literals, false /*learnt*/);
+            proof->notify_added_clause(c->literals(), false /*learnt*/);
+        stats.steps += c->size();
         for (int lit : *c)
         {
             occs(lit).push_back(c);
@@ -274,6 +492,7 @@ namespace BVA
         // Do not use .find() as it relies on pointer equality
         for (auto it = cnf.begin(bucketIndex); it != cnf.end(bucketIndex); it++)
         {
+            stats.steps++;
             if (clausesAreIdentical(**it, c))
             {
                 Clause *clause_to_delete = *it;
@@ -290,6 +509,7 @@ namespace BVA
         for (int lit : c)
         {
             auto &os = occs(lit);
+            stats.steps += os.size();
             const auto end = os.end();
             auto i = os.begin();
             for (auto j = i; j != end; j++)
@@ -333,15 +553,19 @@ namespace BVA
                                                              size_vars(0),
                                                              max_var(0),
                                                              max_iterations(10000000),
-                                                             cnf(0, ClauseHasher())
+                                                             tie_breaking(TieBreaking::NONE),
+                                                             effort(0),
+                                                             min_rate(0),
+                                                             elim_occ_limit(10),
+                                                             cnf(0, ClauseHasher()),
+                                                             hops_lit(0)
     {
         memset(&stats, 0, sizeof(stats));
     }
 
     AutomatedReencoder::~AutomatedReencoder()
     {
-        for (Clause *c : cnf)
-            delete c;
+        // Clauses live in the arena, which releases all its slabs at once.
         cnf.clear();
     }
 
@@ -350,22 +574,25 @@ namespace BVA
     void AutomatedReencoder::applySimpleBVA()
     {
         TIME_BLOCK("[PREPROCESSOR] Simple Bounded Variable Addition");
+        int64_t formula_size = 0; // # of literals
 
         // if (proof)
         //     proof->notify_comment("Applying Simple Bounded Addition Algorithm:");
 
         {
             TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
-            assert(max_var <= size_vars);
-            otab.resize(2 * size_vars + 2, Occs());
-            for (Clause *c : cnf)
-            {
-                assert(c);
-                for (int lit : *c)
-                    occs(lit).push_back(c);
-            }
+            formula_size = connectOccurrences();
+            P_cls.resize(otab.size());
         }
 
+        // Both the effort budget and the reduction rate are measured in steps.
+        // The rate is checked once every 'window' steps and smoothed over
+        // windows, since replacements come in bursts.
+        const int64_t max_steps = effort > 0 ? stats.steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const int64_t window = max<int64_t>(formula_size, Bva_min_rate_window);
+        int64_t next_check = stats.steps + window, last_steps = stats.steps, last_reduced = stats.deleted - stats.added;
+        double smoothed_rate = -1;
+
         priority_queue<pair<size_t, int>> Q;
 
         {
@@ -381,12 +608,36 @@ namespace BVA
         }
 
         int iteration = 0;
+        const char *limit_reached = nullptr;
         // Main algorithm loop
         while (!Q.empty())
         {
             // Check if maximum iteration limit has been reached
             if (++iteration > max_iterations)
+            {
+                limit_reached = "max iterations";
                 break;
+            }
+            if (stats.steps > max_steps)
+            {
+                limit_reached = "effort";
+                break;
+            }
+            if (min_rate > 0 && stats.steps >= next_check)
+            {
+                // Clauses reduced per 1000 steps since the last check
+                const int64_t reduced = stats.deleted - stats.added;
+                const double rate = 1000.0 * (reduced - last_reduced) / (stats.steps - last_steps);
+                smoothed_rate = smoothed_rate < 0 ? rate : (smoothed_rate + rate) / 2;
+                DEBUG_MSG(cout << "rate = " << rate << " smoothed = " << smoothed_rate << endl;);
+                if (smoothed_rate < min_rate)
+                {
+                    limit_reached = "reduction rate";
+                    break;
+                }
+                last_steps = stats.steps, last_reduced = reduced;
+                next_check = stats.steps + window;
+            }
             // UPDATE_PROGRESS("[PREPROCESSOR] Iteration " + to_string(iteration));
 
             // Ensure the next element is not stale
@@ -399,14 +650,13 @@ namespace BVA
             const auto &F_l = occs(l);
             assert(occCount == F_l.size());
 
-            vector<Clause *> M_cls(F_l);
-            set<int> M_lit = {l};
+            M_cls.assign(F_l.begin(), F_l.end());
+            M_lit.assign(1, l);
 
         label1:
-            LitMap P = {};
-            assert(P.empty());
+            assert(P_touched.empty());
 
-            DEBUG_MSG(dumpReplacebleMatching(M_lit, M_cls););
+            DEBUG_MSG(dumpReplacebleMatching(););
 
             // Lines 5-10
             for (const auto &c : M_cls)
@@ -417,42 +667,68 @@ namespace BVA
                 assert(l_min && l_min != l);
                 const auto &F_l_min = occs(l_min);
 
+                for (int lit : *c)
+                    if (lit != l)
+                        mark(lit);
+
                 // Lines 7-10
                 for (const auto &d : F_l_min)
-                    if (l == getSingleLiteralDifference(c, d))
-                    {
-                        int l_ = getSingleLiteralDifference(d, c);
-                        assert(l_);
-                        if (!existsInLitMap(P, l_, *c))
-                            P[l_].push_back(c);
-                    }
-                
-                DEBUG_MSG(dumpLitMap(P););
+                {
+                    int l_ = getReplacingLiteral(d, c->size(), l);
+                    if (!l_)
+                        continue;
+                    // The formula has no duplicates, so each (l_, c) pair is found once
+                    auto &P_l_ = matched(l_);
+                    assert(P_l_.empty() || P_l_.back() != c);
+                    if (P_l_.empty())
+                        P_touched.push_back(l_);
+                    P_l_.push_back(c);
+                }
+
+                for (int lit : *c)
+                    if (lit != l)
+                        unmark(lit);
+
+                DEBUG_MSG(dumpLitMap(););
             }
 
-            if (P.size())
+            if (!P_touched.empty())
             {
-                // Line 11
-                int l_max = 0, l_max_occs = 0;
-                for (const auto &p : P)
-                    if (occs(p.first).size() > l_max_occs)
-                    {
-                        l_max = p.first;
-                        l_max_occs = occs(p.first).size();
-                    }
+                // Line 11: the literal matching the most clauses of M_cls
+                int l_max = 0, l_max_matches = 0;
+                int64_t l_max_hops = -1;
+                for (int l_ : P_touched)
+                {
+                    const int l_matches = matched(l_).size();
+                    if (l_matches < l_max_matches)
+                        continue;
+                    if (l_matches == l_max_matches && !breaksTie(l, l_max, l_, l_max_hops))
+                        continue;
+                    if (l_matches > l_max_matches)
+                        l_max_hops = -1;
+                    l_max = l_;
+                    l_max_matches = l_matches;
+                }
                 assert(l_max);
 
                 DEBUG_MSG(cout << "l_max = " << l_max << endl;);
 
                 // Lines 12-16
-                if (reductionIncreases(P, M_lit, M_cls, l_max))
+                if (reductionIncreases(l_max))
                 {
                     DEBUG_MSG(cout << "REDUCTION INCREASES!" << endl;);
-                    M_lit.insert(l_max);
-                    M_cls.clear();
-                    M_cls.insert(M_cls.end(), P[l_max].begin(), P[l_max].end());
-                    goto label1;
+                    auto pos = lower_bound(M_lit.begin(), M_lit.end(), l_max);
+                    if (pos == M_lit.end() || *pos != l_max)
+                        M_lit.insert(pos, l_max);
+                    const auto &P_l_max = matched(l_max);
+                    M_cls.assign(P_l_max.begin(), P_l_max.end());
+                    clearMatched();
+                    // Out of effort: apply the matching found so far, the loop then stops
+                    if (stats.steps <= max_steps)
+                        goto label1;
                 }
+                else
+                    clearMatched();
             }
             else
                 DEBUG_MSG(cout << "P is empty" << endl;);
@@ -461,31 +737,39 @@ namespace BVA
             if (M_lit.size() == 1)
                 continue;
 
-            vector<Clause *> to_deallocate;
+            to_deallocate.clear();
 
             // Lines 18-22
             int x = introduceNewVariable();
             for (int l_ : M_lit)
             {
-                Clause *new_clause = new Clause({x, l_});
+                Clause *new_clause = arena.allocate({x, l_});
                 newClause(Q, new_clause);
                 for (Clause *c : M_cls)
                 {
-                    Clause d = {l_};
+                    // Temporary lookup key, recycled right away
+                    Clause *d = arena.allocate(c->size());
+                    int j = 0;
+                    (*d)[j++] = l_;
                     for (int ll : *c)
                         if (ll != l)
-                            d.push_back(ll);
-                    removeClause(Q, d, to_deallocate);
+                            (*d)[j++] = ll;
+                    assert(j == d->size());
+                    removeClause(Q, *d, to_deallocate);
+                    arena.release(d);
                 }
             }
 
             // Lines 23-24
             for (const auto &c : M_cls)
             {
-                Clause *d = new Clause({-x});
+                Clause *d = arena.allocate(c->size());
+                int j = 0;
+                (*d)[j++] = -x;
                 for (int lit : *c)
                     if (lit != l)
-                        d->push_back(lit);
+                        (*d)[j++] = lit;
+                assert(j == d->size());
                 newClause(Q, d);
             }
 
@@ -494,18 +778,19 @@ namespace BVA
                 Clause *d = to_deallocate[i];
                 assert(!d->active);
                 if (proof)
-                    proof->notify_deleted_clause(d->literals);
+                    proof->notify_deleted_clause(d->literals());
                 cnf.erase(d);
-                delete d;
+                arena.release(d);
             }
 
+            hops_lit = 0; // the incidence graph has changed
             Q.push({occs(l).size(), l});
             Q.push({occs(-x).size(), -x});
             Q.push({occs(x).size(), x});
         }
 
-        if (iteration > max_iterations)
-            cout << " -> Reached max iterations limit" << endl;
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
         else
             cout << " -> Algorithm ended" << endl;
 
@@ -514,6 +799,10 @@ namespace BVA
         cout << "[PREPROCESSOR]    " << stats.deleted << " clauses deleted" << endl;
         cout << "[PREPROCESSOR]    " << stats.deleted - stats.added << " clauses reduced in total" << endl;
         cout << "[PREPROCESSOR]    " << stats.aux_vars << " auxiliary variables used" << endl;
+        if (tie_breaking != TieBreaking::NONE)
+            cout << "[PREPROCESSOR]    " << stats.ties << " ties broken" << endl;
+        cout << "[PREPROCESSOR]    " << stats.steps << " steps (" << (formula_size ? (double)stats.steps / formula_size : 0) << " per literal)" << endl;
+        cout << "[PREPROCESSOR]    " << arena.memory() / 1024 << " KB clause arena (" << arena.recycled() << " clauses recycled)" << endl;
         
         if (proof)
         {
@@ -527,7 +816,7 @@ namespace BVA
     void AutomatedReencoder::readCNF(ifstream &in)
     {
         TIME_BLOCK("[PREPROCESSOR] Reading CNF");
-        int64_t num_tautologies = 0;
+        int64_t num_skipped = 0;
         assert(cnf.empty());
         string line;
         bool pLineFound = false;
@@ -569,7 +858,7 @@ namespace BVA
             // Otherwise, we assume this line contains exactly one clause
             // terminated by 0.
             stringstream ss(line);
-            Clause clause;
+            vector<int> clause;
 
             int literal;
             while (ss >> literal)
@@ -580,25 +869,98 @@ namespace BVA
                     break;
                 }
                 clause.push_back(literal);
-                if (max_var < abs(literal))
-                    max_var = abs(literal);
-                if (size_vars < abs(literal))
-                    enlarge_marks(abs(literal));
             }
-            if (!tautological(clause))
-                cnf.insert(new Clause(imported_clause));
-            else
-                num_tautologies++;
+            if (!addClause(clause))
+                num_skipped++;
         }
         assert(pLineFound);
         assert(max_var == numVariables);                      // Can be relaxed
-        assert((cnf.size() + num_tautologies) == numClauses); // Can be relaxed
+        assert((cnf.size() + num_skipped) == numClauses); // Can be relaxed
 
-        DEBUG_MSG(cout << num_tautologies << " tautological clauses has been found" << endl;);
+        DEBUG_MSG(cout << num_skipped << " tautological or duplicated clauses has been found" << endl;);
+    }
+
+    // Adds a clause given in DIMACS literals. Tautologies and duplicates
+    // (which would be matched twice by BVA) are skipped.
+    // Returns whether the clause was added.
+    bool AutomatedReencoder::addClause(const vector<int> &clause)
+    {
+        for (int lit : clause)
+        {
+            if (max_var < abs(lit))
+                max_var = abs(lit);
+            if (size_vars < abs(lit))
+                enlarge_marks(abs(lit));
+        }
+        if (tautological(clause))
+            return false;
+        Clause *c = arena.allocate(imported_clause);
+        if (find(*c))
+        {
+            arena.release(c);
+            return false;
+        }
+        cnf.insert(c);
+        return true;
     }
 
     int AutomatedReencoder::maxVar() const { return max_var; }
 
+    // Variables up to 'val' are in use even if they do not occur in the
+    // clauses, so auxiliary variables are introduced after them.
+    void AutomatedReencoder::setMaxVar(int val)
+    {
+        assert(val > 0);
+        if (size_vars < static_cast<unsigned>(val))
+            enlarge_marks(val);
+        if (max_var < val)
+            max_var = val;
+    }
+
+    int64_t AutomatedReencoder::auxVars() const { return stats.aux_vars; }
+
+    // Moves the formula out of the reencoder as one contiguous buffer, so a
+    // solver can adopt it as is: every clause with two or more literals is
+    // written as its size, 'reserved' zeroed ints and its literals mapped
+    // through 'encode'. Unit clauses go to 'units'. The reencoder memory is
+    // released right after.
+    void AutomatedReencoder::exportCNF(vector<int> &clauses, vector<int> &units, int reserved, unsigned (*encode)(int))
+    {
+        TIME_BLOCK("[PREPROCESSOR] Exporting CNF");
+        assert(reserved >= 0);
+        size_t total = 0;
+        for (const Clause *c : cnf)
+            if (!unary(c))
+                total += 1 + reserved + c->size();
+        clauses.clear();
+        clauses.reserve(total);
+        for (const Clause *c : cnf)
+        {
+            if (unary(c))
+            {
+                units.push_back(encode((*c)[0]));
+                continue;
+            }
+            clauses.push_back(c->size());
+            clauses.insert(clauses.end(), reserved, 0);
+            for (int lit : *c)
+                clauses.push_back(encode(lit));
+        }
+        assert(clauses.size() == total);
+        release();
+    }
+
+    void AutomatedReencoder::release()
+    {
+        unordered_set<Clause *, ClauseHasher>(0, ClauseHasher()).swap(cnf);
+        vector<Occs>().swap(otab);
+        vector<Occs>().swap(P_cls);
+        vector<Clause *>().swap(M_cls);
+        vector<Clause *>().swap(to_deallocate);
+        vector<int>().swap(extension);
+        arena.clear();
+    }
+
     void AutomatedReencoder::dumpCNF() const
     {
         TIME_BLOCK("[PREPROCESSOR] Dumping CNF");
@@ -629,6 +991,26 @@ namespace BVA
         max_iterations = val;
     }
 
+    void AutomatedReencoder::setTieBreaking(TieBreaking val) { tie_breaking = val; }
+
+    void AutomatedReencoder::setEffort(double val)
+    {
+        assert(val >= 0);
+        effort = val;
+    }
+
+    void AutomatedReencoder::setMinRate(double val)
+    {
+        assert(val >= 0);
+        min_rate = val;
+    }
+
+    void AutomatedReencoder::setEliminationLimit(int val)
+    {
+        assert(val >= 0);
+        elim_occ_limit = val;
+    }
+
     void AutomatedReencoder::writeDimacsCNF(const char *fname) const
     {
         string msg = "[PREPROCESSOR] Processed CNF successfully written to " + string(fname);
@@ -691,7 +1073,7 @@ namespace BVA
         }
     }
 
-    void AutomatedReencoder::dumpReplacebleMatching(const set<int> &M_lit, const vector<Clause *> &M_cls) const
+    void AutomatedReencoder::dumpReplacebleMatching() const
     {
         cout << "M_lit = ";
         for (int lit : M_lit)
@@ -703,13 +1085,13 @@ namespace BVA
         cout << "}" << endl;
     }
 
-    void AutomatedReencoder::dumpLitMap(const LitMap &P_cls) const
+    void AutomatedReencoder::dumpLitMap() const
     {
         cout << "P = {" << endl;
-        for (const auto &entry : P_cls)
+        for (int lit : P_touched)
         {
-            cout << "   " << entry.first << " -> { ";
-            for (const Clause *clause : entry.second)
+            cout << "   " << lit << " -> { ";
+            for (const Clause *clause : matched(lit))
             {
                 cout << *clause << " ";
             }
@@ -1,4 +1,6 @@
+#pragma once
 #include <queue>
+#include <algorithm>
 #include <set>
 #include <cstdint>
 #include <limits.h>
@@ -17,34 +19,91 @@
 
 using namespace std;
 
+// Minimal # of steps between two checks of the BVA reduction rate
+#define Bva_min_rate_window 100000
+// Maximal size of a clause resolved on or produced by variable elimination
+#define Bve_clause_limit 100
+
 namespace BVA
 {
+    // Clauses are allocated from a 'ClauseArena' with their literals stored
+    // inline right after this header, so a clause is a single allocation.
+    // Never create or copy a clause directly, use 'ClauseArena::allocate'.
     class Clause
     {
     public:
-        Clause() : active(true) {}
-        Clause(initializer_list<int> init)
-            : literals(init), active(true) {}
-        Clause(const vector<int> &init)
-            : literals(init), active(true) {}
-        int size() const { return literals.size(); }
-        void push_back(int lit) { literals.push_back(lit); }
-        std::vector<int> literals;
         bool active;
-        std::vector<int>::iterator begin() { return literals.begin(); }
-        std::vector<int>::iterator end() { return literals.end(); }
-        std::vector<int>::const_iterator begin() const { return literals.cbegin(); }
-        std::vector<int>::const_iterator end() const { return literals.cend(); }
-        int& operator[](std::size_t i) { return literals[i]; }
-        const int& operator[](std::size_t i) const { return literals[i]; }
+        unsigned cap; // number of literal slots (size class)
+        int sz;
+        unsigned sig; // bit (var % 32) set for every variable. Only maintained during subsumption
+        int lits[2]; // actually 'cap' literals, embedded in the arena
+
+        int size() const { return sz; }
+        int *begin() { return lits; }
+        int *end() { return lits + sz; }
+        const int *begin() const { return lits; }
+        const int *end() const { return lits + sz; }
+        int &operator[](std::size_t i) { return lits[i]; }
+        const int &operator[](std::size_t i) const { return lits[i]; }
+        vector<int> literals() const { return vector<int>(begin(), end()); }
+
+        Clause(const Clause &) = delete;
+        Clause &operator=(const Clause &) = delete;
+        Clause() = delete;
+    };
+
+    // Slab allocator for clauses. Memory is carved out of large slabs with a
+    // bump pointer. Released clauses are recycled through free lists indexed
+    // by size class, and all slabs are returned at once on 'clear' or
+    // destruction without visiting the individual clauses.
+    class ClauseArena
+    {
+    private:
+        static constexpr unsigned exact_classes = 32; // capacities 1..32 are exact, then powers of two
+        static constexpr size_t min_slab_bytes = 1 << 20;
+
+        vector<char *> slabs;
+        char *top, *limit;          // bump pointer into the last slab
+        vector<Clause *> free_lists; // size class => singly linked list of released clauses
+        struct
+        {
+            int64_t allocated, recycled, released;
+            size_t bytes;
+        } stats;
+
+        static unsigned size_class(unsigned size);
+        static unsigned class_capacity(unsigned cls);
+        static size_t bytes(unsigned cap);
+        char *bump(size_t bytes);
+
+    public:
+        ClauseArena();
+        ~ClauseArena();
+        ClauseArena(const ClauseArena &) = delete;
+        ClauseArena &operator=(const ClauseArena &) = delete;
+
+        Clause *allocate(int size);
+        Clause *allocate(initializer_list<int> lits);
+        Clause *allocate(const vector<int> &lits);
+        void release(Clause *);
+        void clear();
+        size_t memory() const { return stats.bytes; }
+        int64_t recycled() const { return stats.recycled; }
     };
 
     typedef vector<Clause *> Occs;
-    typedef unordered_map<int, vector<Clause*>> LitMap;
 
     // Overload the << operator for Clause
     std::ostream &operator<<(std::ostream &os, const Clause &c);
 
+    enum class TieBreaking
+    {
+        /* First candidate found */
+        NONE,
+        /* SBVA: most paths of length 3 to the matched literal in the variable incidence graph */
+        THREE_HOP
+    };
+
     struct ClauseHasher {
         size_t operator()(const Clause *c) const {
             size_t h = 0;
@@ -65,13 +124,56 @@ namespace BVA
         vector<char> seen;
         vector<Occs> otab;
         int max_var, max_iterations;
+        TieBreaking tie_breaking;
+        double effort;   // step budget relative to the formula size, 0: unlimited
+        double min_rate; // adaptive stop threshold, 0: disabled
+        int elim_occ_limit; // BVE only resolves on variables with fewer occurrences per polarity
         struct
         {
-            int64_t added, deleted, aux_vars;
+            int64_t added, deleted, aux_vars, ties;
+            int64_t steps; // occurrence-list visits and clause comparisons
+            int64_t eliminated, resolvents, gates, elim_steps;
+            int64_t subsumed, strengthened, sub_steps;
+            int64_t units, satisfied, falsified, pure, simp_steps;
+            int64_t and_gates, xor_gates, ite_gates, merged, coi_removed, strash_steps;
         } stats;
 
+        ClauseArena arena;
         unordered_set<Clause *, ClauseHasher> cnf;
 
+        // Scratch buffers of the matching loop, reused across iterations
+        vector<Occs> P_cls;             // vlit(l_) => clauses of M_cls matched with l_
+        vector<int> P_touched;          // literals with a non-empty P_cls entry
+        vector<int> M_lit;              // sorted
+        vector<Clause *> M_cls;
+        vector<Clause *> to_deallocate;
+
+        // Used by TieBreaking::THREE_HOP: var => # of paths of length 1 and 2
+        // from the variable of 'hops_lit'. Computed lazily once per matched literal.
+        int hops_lit;
+        vector<int64_t> hop1, hop2;
+        vector<int> hop1_touched, hop2_touched;
+
+        // Used by BVE
+        vector<char> eliminated;   // var => eliminated
+        vector<int> extension;     // eliminated clauses, see 'exportExtension'
+        vector<int> resolvents;    // candidate resolvents, each one followed by 0
+        vector<int> resolvent;
+        vector<Clause *> gate;
+
+        // Used by subsumption: clauses to strengthen and the literal to remove
+        vector<pair<Clause *, int>> to_strengthen;
+
+        // Used by structural hashing: a gate and its clauses, which are in 'gate'
+        enum class GateType { AND, XOR, ITE };
+        struct Gate
+        {
+            GateType type;
+            int output;         // literal
+            vector<int> inputs; // AND: any number, XOR: two variables, ITE: condition, then, else
+        };
+        vector<int> repr; // var => the literal it was merged into. 0 if none
+
     private:
         int vidx(int lit) const;
         unsigned vlit(int lit) const;
@@ -81,13 +183,36 @@ namespace BVA
         signed char marked(int lit) const;
         void mark(int lit);
         void unmark(int lit);
-        bool tautological(const Clause &c);
+        bool tautological(const vector<int> &c);
         Clause* find(Clause &c);
-        bool existsInLitMap(const LitMap &, int, Clause &);
+        Occs &matched(int lit);
+        const Occs &matched(int lit) const;
+        void clearMatched();
         int getLeastOccurring(Clause *, int);
-        int getSingleLiteralDifference(Clause *, Clause *);
-        bool reductionIncreases(const LitMap &, const set<int> &, const vector<Clause *> &, int) const;
+        int getReplacingLiteral(const Clause *, int, int);
+        bool reductionIncreases(int) const;
+        void computeTwoHops(int);
+        int64_t threeHops(int, int);
+        bool breaksTie(int, int, int, int64_t &);
         int introduceNewVariable();
+        int64_t connectOccurrences();
+        bool findGate(int);
+        bool resolve(const Clause *, const Clause *, int);
+        bool tryEliminate(int, priority_queue<pair<size_t, int>, vector<pair<size_t, int>>, greater<pair<size_t, int>>> &);
+        bool findXorGate(int, Gate &);
+        bool findIteGate(int, Gate &);
+        bool findAnyGate(int, Gate &);
+        int representative(int);
+        int strashKey(const Gate &, vector<int> &);
+        void addDerived(const vector<int> &, int);
+        bool merge(const Gate &, int, int);
+        void substituteMerged();
+        void removeUnusedGates();
+        unsigned signature(const Clause *) const;
+        void subsumeBackward(Clause *, vector<Clause *> &);
+        void strengthen(Clause *, int, vector<Clause *> &);
+        void removeSubsumed(Clause *);
+        void disconnect(Clause *);
         bool clausesAreIdentical(const Clause &, const Clause &);
         bool unary(const Clause *) const;
         Clause *newClause(priority_queue<pair<size_t, int>> &, Clause *);
@@ -95,18 +220,34 @@ namespace BVA
         void popExpiredElementsFromHeap(priority_queue<pair<size_t, int>> &);
         void dumpCNF() const;
         void dumpOccurrences() const;
-        void dumpReplacebleMatching(const set<int> &M_lit, const vector<Clause *> &M_cls) const;
-        void dumpLitMap(const LitMap &P_cls) const;
+        void dumpReplacebleMatching() const;
+        void dumpLitMap() const;
 
     public:
         AutomatedReencoder(ProofTracer *);
         ~AutomatedReencoder();
         int num_occs(int) const;
         void applySimpleBVA();
+        void applyBVE();
+        void applySubsumption();
+        void applyUnitPropagation();
+        void applyPureLiterals();
+        void applyStrash();
         void readCNF(std::ifstream &);
+        bool addClause(const vector<int> &);
         const unordered_set<Clause *, ClauseHasher> &getCNF() const { return cnf; }
+        void exportCNF(vector<int> &, vector<int> &, int, unsigned (*)(int));
+        void exportExtension(vector<int> &);
+        void release();
         int maxVar() const;
+        void setMaxVar(int);
+        int64_t auxVars() const;
         void setIterations(int);
+        void setTieBreaking(TieBreaking);
+        void setEffort(double);
+        double getEffort() const { return effort; }
+        void setMinRate(double);
+        void setEliminationLimit(int);
         void writeDimacsCNF(const char *) const;
     };
 };
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "bva.h"
+
+// Bounded Variable Elimination (BVE) by clause distribution, as in SatElite.
+// It works on the same clause set, occurrence lists and marks as SimpleBVA,
+// so both can be applied to the formula one after the other.
+
+namespace BVA
+{
+    typedef priority_queue<pair<size_t, int>, vector<pair<size_t, int>>, greater<pair<size_t, int>>> ElimQueue;
+
+    // Looks for the clauses defining 'lit' as an AND gate (or an equivalence
+    // when n = 1): (-lit | a_i) for i = 1..n and (lit | -a_1 | ... | -a_n).
+    // On success they are appended to 'gate'.
+    bool AutomatedReencoder::findGate(int lit)
+    {
+        vector<int> &inputs = resolvent; // scratch, not in use here
+        inputs.clear();
+        for (Clause *c : occs(-lit))
+        {
+            stats.elim_steps++;
+            if (c->size() != 2)
+                continue;
+            int other = (*c)[0] == -lit ? (*c)[1] : (*c)[0];
+            if (marked(other))
+                continue; // both polarities imply 'lit' is false
+            mark(other);
+            inputs.push_back(other);
+        }
+        Clause *base = nullptr;
+        if (!inputs.empty())
+            for (Clause *c : occs(lit))
+            {
+                stats.elim_steps += c->size();
+                bool all = true;
+                for (int other : *c)
+                    if (other != lit && marked(-other) <= 0)
+                    {
+                        all = false;
+                        break;
+                    }
+                if (all)
+                {
+                    base = c;
+                    break;
+                }
+            }
+        for (int other : inputs)
+            unmark(other);
+        if (!base)
+            return false;
+
+        gate.push_back(base);
+        for (int other : *base)
+            if (other != lit)
+                mark(-other);
+        for (Clause *c : occs(-lit))
+        {
+            if (c->size() != 2)
+                continue;
+            int other = (*c)[0] == -lit ? (*c)[1] : (*c)[0];
+            if (marked(other) > 0)
+            {
+                gate.push_back(c);
+                unmark(other); // binary clauses are not duplicated anyway
+            }
+        }
+        for (int other : *base)
+            if (other != lit)
+                unmark(other);
+        return true;
+    }
+
+    // Computes the resolvent of c and d on 'pivot' (in c) into 'resolvent'.
+    // Returns false if it is tautological.
+    bool AutomatedReencoder::resolve(const Clause *c, const Clause *d, int pivot)
+    {
+        resolvent.clear();
+        stats.elim_steps += c->size() + d->size();
+        for (int lit : *c)
+            if (lit != pivot)
+            {
+                mark(lit);
+                resolvent.push_back(lit);
+            }
+        bool tautological = false;
+        for (int lit : *d)
+        {
+            if (lit == -pivot)
+                continue;
+            const signed char tmp = marked(lit);
+            if (tmp < 0)
+            {
+                tautological = true;
+                break;
+            }
+            if (!tmp)
+                resolvent.push_back(lit);
+        }
+        for (int lit : *c)
+            if (lit != pivot)
+                unmark(lit);
+        return !tautological;
+    }
+
+    // Eliminates 'x' if the non-tautological resolvents are not more than the
+    // clauses they replace. When 'x' is defined by a gate, only resolvents of
+    // a gate clause with a non-gate clause are needed.
+    bool AutomatedReencoder::tryEliminate(int x, ElimQueue &Q)
+    {
+        const Occs &pos = occs(x), &neg = occs(-x);
+        if (pos.empty() && neg.empty())
+            return false;
+        if (pos.size() > (size_t)elim_occ_limit || neg.size() > (size_t)elim_occ_limit)
+            return false;
+        for (int lit : {x, -x})
+            for (const Clause *c : occs(lit))
+                if (unary(c) || c->size() > Bve_clause_limit)
+                    return false;
+
+        gate.clear();
+        const bool gated = findGate(x) || findGate(-x);
+        auto in_gate = [&](Clause *c)
+        { return std::find(gate.begin(), gate.end(), c) != gate.end(); };
+
+        const size_t bound = pos.size() + neg.size();
+        size_t count = 0;
+        resolvents.clear();
+        for (Clause *c : pos)
+            for (Clause *d : neg)
+            {
+                if (gated && in_gate(c) == in_gate(d))
+                    continue;
+                if (!resolve(c, d, x))
+                    continue;
+                if (++count > bound || resolvent.size() > Bve_clause_limit)
+                    return false;
+                resolvents.insert(resolvents.end(), resolvent.begin(), resolvent.end());
+                resolvents.push_back(0);
+            }
+
+        // Resolvents first, so the proof can derive them before the deletions
+        for (size_t i = 0, j = 0; i < resolvents.size(); j = ++i)
+        {
+            while (resolvents[i])
+                i++;
+            resolvent.assign(resolvents.begin() + j, resolvents.begin() + i);
+            Clause *c = arena.allocate(resolvent);
+            if (find(*c))
+            {
+                arena.release(c);
+                continue;
+            }
+            if (proof)
+                proof->notify_added_clause(resolvent, false /*learnt*/);
+            cnf.insert(c);
+            for (int lit : *c)
+            {
+                occs(lit).push_back(c);
+                Q.push({occs(lit).size() * occs(-lit).size(), vidx(lit)});
+            }
+            stats.resolvents++;
+        }
+
+        // The eliminated clauses are saved on the extension stack, each one
+        // with 'x' in its polarity as witness
+        for (int lit : {x, -x})
+        {
+            for (Clause *c : occs(lit))
+            {
+                extension.push_back(0);
+                extension.insert(extension.end(), c->begin(), c->end());
+                extension.push_back(lit);
+                if (proof)
+                    proof->notify_deleted_clause(c->literals());
+                for (int other : *c)
+                {
+                    if (other == lit)
+                        continue;
+                    Occs &os = occs(other);
+                    stats.elim_steps += os.size();
+                    os.erase(std::find(os.begin(), os.end(), c));
+                    Q.push({os.size() * occs(-other).size(), vidx(other)});
+                }
+                cnf.erase(c);
+                arena.release(c);
+            }
+            occs(lit).clear();
+        }
+        eliminated[x] = true;
+        stats.eliminated++;
+        if (gated)
+            stats.gates++;
+        return true;
+    }
+
+    void AutomatedReencoder::applyBVE()
+    {
+        TIME_BLOCK("[PREPROCESSOR] Bounded Variable Elimination");
+        int64_t formula_size;
+        {
+            TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
+            formula_size = connectOccurrences();
+        }
+        eliminated.resize(max_var + 1);
+
+        // Cheapest variables first, by the # of possible resolvents. Entries
+        // are pushed again whenever occurrences change, stale ones skipped.
+        ElimQueue Q;
+        for (int v = 1; v <= max_var; ++v)
+            Q.push({occs(v).size() * occs(-v).size(), v});
+
+        const int64_t max_steps = effort > 0 ? stats.elim_steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const char *limit_reached = nullptr;
+        while (!Q.empty())
+        {
+            if (stats.elim_steps > max_steps)
+            {
+                limit_reached = "effort";
+                break;
+            }
+            auto [cost, v] = Q.top();
+            Q.pop();
+            if (eliminated[v] || cost != occs(v).size() * occs(-v).size())
+                continue;
+            tryEliminate(v, Q);
+        }
+
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
+        else
+            cout << " -> Algorithm ended" << endl;
+
+        cout << "[PREPROCESSOR] Statistics:" << endl;
+        cout << "[PREPROCESSOR]    " << stats.eliminated << " variables eliminated (" << stats.gates << " by gates)" << endl;
+        cout << "[PREPROCESSOR]    " << stats.resolvents << " resolvents added" << endl;
+        cout << "[PREPROCESSOR]    " << cnf.size() << " clauses remaining" << endl;
+        cout << "[PREPROCESSOR]    " << stats.elim_steps << " steps (" << (formula_size ? (double)stats.elim_steps / formula_size : 0) << " per literal)" << endl;
+
+        if (proof)
+        {
+            proof->notify_comment("    " + to_string(stats.eliminated) + " variables eliminated");
+            proof->notify_comment("    " + to_string(stats.resolvents) + " resolvents added");
+        }
+    }
+
+    // Moves the extension stack out of the reencoder. For every eliminated
+    // clause it holds 0, the clause literals and its witness literal, in the
+    // order of elimination. A model of the remaining formula is extended by
+    // going over it backwards and flipping the witness of every clause that
+    // is not satisfied.
+    void AutomatedReencoder::exportExtension(vector<int> &res)
+    {
+        res.swap(extension);
+        extension.clear();
+    }
+};
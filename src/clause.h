@@ -1,34 +1,44 @@
 #pragma once
 #include "edusat-header.h"
 
+// A clause is stored inside the clause database (ClauseDB) as a small header
+// followed by its literals. It is never copied: clauses are referred to by
+// their index, which is their offset into the database memory.
 class Clause {
-	clause_t c;
-	int lw,rw; //watches;	
-public:	
-	Clause(){};
-	void insert(int i) {c.push_back(i);}
+	unsigned sz : 31;
+	unsigned removed : 1; // by ClauseDB::remove(). Still watched until ClauseDB::compact()
+	int lw,rw; //watches;
+	int pos; // where the last replacement watch was found. The next search starts there
+	Lit c[2]; // actually 'sz' literals
+public:
+	static const int header_size = 4; // # of ints before the literals
+	Clause() = delete;
+	Clause(const Clause&) = delete;
+	Clause& operator=(const Clause&) = delete;
 	void lw_set(int i) {lw = i; /*assert(lw != rw);*/}
-	void rw_set(int i) {rw = i; /*assert(lw != rw);*/}	
-	clause_t& cl() {return c;}
+	void rw_set(int i) {rw = i; /*assert(lw != rw);*/}
 	int get_lw() {return lw;}
 	int get_rw() {return rw;}
 	int get_lw_lit() {return c[lw];}
 	int get_rw_lit() {return c[rw];}
+	int get_pos() {return pos;}
+	void pos_set(int i) {pos = i;}
 	int  lit(int i) {return c[i];}
-	size_t size() {return c.size();}
-	void reset() { c.clear(); }	
-	void print() {for (clause_it it = c.begin(); it != c.end(); ++it) {cout << *it << " ";}; }
+	size_t size() {return sz;}
+	bool is_removed() const {return removed;}
+	void removed_set() {removed = 1;}
+	void print() {for (Lit *it = begin(); it != end(); ++it) {cout << *it << " ";}; }
 	void print_real_lits() {
-		Lit l; 
-		cout << "("; 
-		for (clause_it it = c.begin(); it != c.end(); ++it) { 
-			l = l2rl(*it); 
-			cout << l << " ";} cout << ")"; 
-	}
-	void print_with_watches() {		
-		for (clause_it it = c.begin(); it != c.end(); ++it) {
+		Lit l;
+		cout << "(";
+		for (Lit *it = begin(); it != end(); ++it) {
+			l = l2rl(*it);
+			cout << l << " ";} cout << ")";
+	}
+	void print_with_watches() {
+		for (Lit *it = begin(); it != end(); ++it) {
 			cout << l2rl(*it);
-			int j = distance(c.begin(), it); //also could write "int j = i - c.begin();"  : the '-' operator is overloaded to allow such things. but distance is more standard, as it works on all standard containers.
+			int j = distance(begin(), it); //also could write "int j = i - c.begin();"  : the '-' operator is overloaded to allow such things. but distance is more standard, as it works on all standard containers.
 			if (j == lw) cout << "L";
 			if (j == rw) cout << "R";
 			cout << " ";
@@ -36,14 +46,146 @@ public:
 	}
 	vector<int> get_raw_copy() const {
 		vector<int> lits;
-		for (clause_cit it = c.cbegin(); it != c.cend(); ++it)
+		for (const Lit *it = cbegin(); it != cend(); ++it)
 			lits.push_back(l2rl(*it));
 		return lits;
 	}
 
     // Iterator
-    clause_it begin() { return c.begin(); }
-    clause_it end() { return c.end(); }
-    clause_cit cbegin() const { return c.cbegin(); }
-    clause_cit cend() const { return c.cend(); }
-};
\ No newline at end of file
+    Lit *begin() { return c; }
+    Lit *end() { return c + sz; }
+    const Lit *cbegin() const { return c; }
+    const Lit *cend() const { return c + sz; }
+};
+
+// All clauses with two or more literals, in one contiguous memory region.
+// Adding a clause may move the region, so Clause references are only valid
+// until the next add(). A removed clause keeps its place, and is skipped by the
+// iterator, until compact() moves the others into a new region.
+class ClauseDB {
+	vector<int> mem;	// clause headers and literals
+	size_t num;			// # clauses, not counting the removed ones
+	size_t garbage;		// # ints of the removed clauses
+	int last_idx;		// index of the most recently added clause. -1 if none.
+
+	int live(int idx) { while (idx < top() && (*this)[idx].is_removed()) idx = next(idx); return idx; }
+public:
+	ClauseDB() : num(0), garbage(0), last_idx(-1) {}
+	Clause& operator[](int idx) { return *reinterpret_cast<Clause*>(mem.data() + idx); }
+	size_t size() const { return num; }
+	int last() const { return last_idx; }
+	int top() const { return static_cast<int>(mem.size()); } // index of the next clause to be added
+	void reserve(size_t clauses) { mem.reserve(clauses * (Clause::header_size + 3)); }
+	size_t memory() const { return mem.capacity() * sizeof(int); }
+	size_t wasted() const { return garbage; } // # ints that compact() frees
+
+	int add(const clause_t& lits, int l, int r) {
+		int idx = static_cast<int>(mem.size());
+		mem.push_back(static_cast<int>(lits.size()));
+		mem.push_back(l);
+		mem.push_back(r);
+		mem.push_back(0);
+		mem.insert(mem.end(), lits.begin(), lits.end());
+		++num;
+		return last_idx = idx;
+	}
+
+	// Takes over a buffer that is already laid out as clauses: size, zeroed
+	// watch and search position slots, literals. Watches are set to the first
+	// two literals.
+	void adopt(vector<int>& buffer) {
+		mem.swap(buffer);
+		buffer.clear();
+		buffer.shrink_to_fit();
+		num = garbage = 0;
+		last_idx = -1;
+		for (int idx = 0; idx < static_cast<int>(mem.size()); idx = next(idx)) {
+			Clause& c = (*this)[idx];
+			Assert(c.size() > 1);
+			c.lw_set(0);
+			c.rw_set(1);
+			c.pos_set(0);
+			++num;
+			last_idx = idx;
+		}
+	}
+
+	// Removes all clauses from index 'idx' on. 'idx' must be the index of a clause or top().
+	void truncate(int idx) {
+		for (int i = idx; i < top(); i = next(i))
+			if ((*this)[i].is_removed())
+				garbage -= Clause::header_size + (*this)[i].size();
+			else
+				--num;
+		mem.resize(idx);
+		last_idx = -1; // not needed before the next add()
+	}
+
+	// The clause stays in the region, and in its watch lists, until compact().
+	void remove(int idx) {
+		Clause& c = (*this)[idx];
+		Assert(!c.is_removed());
+		c.removed_set();
+		--num;
+		garbage += Clause::header_size + c.size();
+	}
+
+	// Copies the clauses that are not removed to a new region of just their
+	// size, in the same order, and returns the old one, in which each clause
+	// holds its new index (see forward()). 'marks' are indices of clauses or
+	// top(), moved to the first copied clause at or after them.
+	vector<int> compact(initializer_list<int*> marks) {
+		vector<int> fresh;
+		fresh.reserve(mem.size() - garbage);
+		vector<pair<int, int*>> pending;
+		for (int *m : marks)
+			pending.push_back({*m, m});
+		sort(pending.begin(), pending.end());
+		auto p = pending.begin();
+		int new_last = -1;
+		for (int idx = 0; idx < top(); idx = next(idx)) {
+			for (; p != pending.end() && p->first <= idx; ++p)
+				*p->second = static_cast<int>(fresh.size());
+			Clause& c = (*this)[idx];
+			if (c.is_removed()) {
+				mem[idx + 1] = -1;
+				continue;
+			}
+			const int to = static_cast<int>(fresh.size());
+			fresh.insert(fresh.end(), mem.begin() + idx, mem.begin() + next(idx));
+			if (idx == last_idx)
+				new_last = to;
+			mem[idx + 1] = to; // the left watch, already copied
+		}
+		for (; p != pending.end(); ++p)
+			*p->second = static_cast<int>(fresh.size());
+		last_idx = new_last;
+		garbage = 0;
+		mem.swap(fresh);
+		return fresh;
+	}
+	// The new index of the clause at 'idx' in the region returned by compact(). -1 if it was removed
+	static int forward(const vector<int>& old, int idx) { return old[idx + 1]; }
+
+	// Iterating over the indices of all clauses that are not removed
+	int next(int idx) { return idx + Clause::header_size + static_cast<int>((*this)[idx].size()); }
+	class iterator {
+		ClauseDB* db;
+		int idx;
+	public:
+		iterator(ClauseDB* _db, int _idx) : db(_db), idx(_idx) {}
+		int operator*() const { return idx; }
+		iterator& operator++() { idx = db->live(db->next(idx)); return *this; }
+		bool operator!=(const iterator& other) const { return idx != other.idx; }
+	};
+	iterator begin() { return iterator(this, live(0)); }
+	iterator end() { return iterator(this, static_cast<int>(mem.size())); }
+};
+
+// An at-most-k constraint: at most 'bound' of 'lits' are true. It stands for the
+// clauses (-l1 v ... v -l_bound+1) of every bound + 1 of its literals (the
+// binomial encoding), which are its explanations in conflict analysis.
+struct Card {
+	int bound;
+	vector<Lit> lits;
+};
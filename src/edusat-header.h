@@ -12,6 +12,12 @@
 #include <fstream>
 #include <cassert>
 #include <ctime>
+#include <cmath>
+#include <random>
+#include <climits>
+#ifdef __GLIBC__
+#include <malloc.h> // malloc_trim
+#endif
 
 using namespace std;
 
@@ -44,7 +50,11 @@ typedef vector<Lit> trail_t;
 
 // ================== Defines ==================
 
+#ifdef NDEBUG
+#define Assert(exp) ((void)0)
+#else
 #define Assert(exp) AssertCheck(exp, __func__, __LINE__)
+#endif
 #define Neg(l) (l & 1)
 #define Restart_multiplier 1.1f
 #define Restart_lower 100
@@ -52,12 +62,38 @@ typedef vector<Lit> trail_t;
 #define Max_bring_forward 10
 #define var_decay 0.99
 #define Rescale_threshold 1e100
+#define Stable_restart_unit 512 // conflicts, times the Luby sequence, between restarts in stable mode
+#define Mode_length_init 1000 // conflicts of the first focused mode, doubled after every stable mode
+#define Lrb_alpha_start 0.4 // LRB step size, decreased by Lrb_alpha_step per conflict down to Lrb_alpha_min
+#define Lrb_alpha_step 1e-6
+#define Lrb_alpha_min 0.06
+#define Lrb_locality_decay 0.95 // per conflict, of the scores of the unassigned variables
+#define Subsume_effort 2 // learnt subsumption steps per learnt literal
+#define Probe_effort 10 // failed literal probing propagations per clause
+#define Card_effort 100 // cardinality extraction steps per clause
+#define Gauss_max_bits (1 << 27) // of the XOR matrix (16MB), rows times columns. Larger systems are not propagated
+#define Chrono_min_conflicts 4000 // conflicts before the first chronological backtrack
+#define Check_interval 1000 // conflicts between invariant checks (-check) by default in checked builds
+#define Prefetch_distance 4 // BCP prefetches the clause of the watcher this many places ahead
+#ifdef NO_PREFETCH
+#define Prefetch(addr) ((void)0)
+#else
+#define Prefetch(addr) __builtin_prefetch(addr)
+#endif
+#define Watch_inline 2 // watch lists up to this long are stored without the pool (see WatchPool)
+#define Watch_pool_min_size (1 << 16) // pool entries before it is ever defragmented
+#define Watch_pool_max_waste 3 // defragment (at a restart, or before growing the pool) when it is this many times the watches in it
 #define Assignment_file "assignment.txt"
 
 // ================== Enums ==================
 
 enum class VAR_DEC_HEURISTIC {
-	MINISAT
+	/* VSIDS, with the scores kept in a map from score to variables */
+	MINISAT,
+	/* Variable move-to-front: the most recently bumped unassigned variable */
+	VMTF,
+	/* Learning rate branching: the highest rate of taking part in conflicts */
+	LRB
 	// add other decision heuristics here. Add an option to choose between them.
  };
 
@@ -74,7 +110,7 @@ enum class LitState {
 	L_UNASSIGNED
 };
 
-enum class VarState {
+enum class VarState : signed char {
 	V_FALSE,
 	V_TRUE,
 	V_UNASSIGNED
@@ -101,6 +137,27 @@ extern int preprocess;
 extern string proof_path;
 extern double timeout;
 extern double solving_begin_time;
+extern int bva_length;
+extern int bva_tiebreak;
+extern int bva_inprocess;
+extern double bva_effort;
+extern double bva_min_rate;
+extern int bve;
+extern int bve_occ_limit;
+extern int subsume_pre;
+extern int subsume_learnts;
+extern int probe_interval;
+extern int target_phases;
+extern int rephase_interval;
+extern int stable_mode;
+extern int walk_effort;
+extern int walk_thread;
+extern int chrono_threshold;
+extern int circular_watch;
+extern int check_interval;
+extern double gc_waste;
+extern int card_bound;
+extern int xor_size;
 extern VAR_DEC_HEURISTIC VarDecHeuristic;
 extern VAL_DEC_HEURISTIC ValDecHeuristic;
 
@@ -150,8 +207,8 @@ inline void Abort(string s, int i) {
 	exit(i);
 }
 
-// For production wrap with #ifdef _DEBUG
-inline void AssertCheck(bool cond, string func_name, int line, string msg = "") {
+// Assert() is compiled out with NDEBUG (make release)
+inline void AssertCheck(bool cond, const char *func_name, int line, const char *msg = "") {
 	if (cond) return;
 	cout << "Assertion fail" << endl;
 	cout << msg << endl;
@@ -1,5 +1,6 @@
 #include "solver.h"
 #include "options.h"
+#include "preprocess.h"
 
 // ================== Global Variables ==================
 
@@ -7,9 +8,34 @@ int verbose = 0;
 int preprocess = 0;
 string proof_path = "";
 string bva_export_path = "";
+string pre_passes = "";
 double solving_begin_time;
 double timeout = 0.0;
 int bva_length = 10000000;
+int bva_tiebreak = 0;
+double bva_effort = 1000.0;
+double bva_min_rate = 0.0;
+int bva_inprocess = 0;
+int bve = 0;
+int bve_occ_limit = 10;
+int subsume_pre = 0;
+int subsume_learnts = 0;
+int probe_interval = 0;
+int target_phases = 0;
+int rephase_interval = 0;
+int stable_mode = 0;
+int walk_effort = 0;
+int walk_thread = 0;
+int chrono_threshold = 0;
+int circular_watch = 0;
+double gc_waste = 0.25;
+int card_bound = 0;
+int xor_size = 0;
+#ifdef CHECKED
+int check_interval = Check_interval; // checked builds check by default
+#else
+int check_interval = 0;
+#endif
 
 VAR_DEC_HEURISTIC VarDecHeuristic = VAR_DEC_HEURISTIC::MINISAT;
 VAL_DEC_HEURISTIC ValDecHeuristic = VAL_DEC_HEURISTIC::PHASESAVING;
@@ -22,9 +48,31 @@ unordered_map<string, option*> options = {
 	{"v",           new intoption(&verbose, 0, 2, "Verbosity level")},
 	{"bva", 		 	new booloption(&preprocess, "{Apply Bounded Variable Addition (BVA) preprocessing technique}")},
 	{"timeout",     new doubleoption(&timeout, 0.0, 36000.0, "Timeout in seconds")},
+	{"vardh",       new intoption((int*)&VarDecHeuristic, 0, 2, "{0: MiniSat (VSIDS), 1: VMTF, 2: LRB}")},
 	{"valdh",       new booloption((int*)&ValDecHeuristic, "{0: phase-saving, 1: literal-score}")},
+	{"target",      new intoption(&target_phases, 0, 2, "{Decide by the target phases (longest conflict-free trail), 0: never, 1: in stable mode, 2: always}")},
+	{"rephase",     new intoption(&rephase_interval, 0, 10000000, "Reset the saved phases every N*k conflicts on the k-th time, cycling original/best/inverted/best/random/best, with a walk after each best if -walk is set (0: never)")},
+	{"walk",        new intoption(&walk_effort, 0, 1000000, "ProbSAT local search for N flips per clause from the saved phases, before the search and when rephasing (0: never)")},
+	{"walk-thread", new booloption(&walk_thread, "{Run ProbSAT on another thread during the search, stopping it with its model if it finds one. Its CPU time counts toward -timeout}")},
+	{"stable",      new intoption(&stable_mode, 0, 2, "{0: focused mode (local restarts) only, 1: alternate focused and stable (Luby restarts) modes, 2: stable mode only}")},
+	{"circular-watch", new booloption(&circular_watch, "{Search for a replacement watch from where the previous search of the clause stopped, wrapping around (Gent)}")},
+	{"chrono",      new intoption(&chrono_threshold, 0, 1000000, "Backtrack chronologically (one level) when the backjump would skip more than N levels (0: never)")},
+	{"gc",          new doubleoption(&gc_waste, 0.0, 1.0, "Remove the clauses satisfied at level 0, and compact the clause DB when this fraction of it is removed clauses (0: never remove)")},
+	{"check",       new intoption(&check_interval, 0, 1000000, "Check the solver invariants every N conflicts, in debug and checked builds only (0: never)")},
 	{"proof", 	 	new stringoption(&proof_path, "Path to proof file")},
 	{"bva-limit",   new intoption(&bva_length, 1, 10000000, "BVA Iterations")},
+	{"bva-tiebreak", new intoption(&bva_tiebreak, 0, 1, "{BVA tie-breaking, 0: first found, 1: SBVA 3-hop heuristic}")},
+	{"bva-effort",  new doubleoption(&bva_effort, 0.0, 1e9, "BVA step budget per literal of the formula (0: unlimited)")},
+	{"bva-min-rate", new doubleoption(&bva_min_rate, 0.0, 1000.0, "Stop BVA when fewer clauses are reduced per 1000 steps (0: never)")},
+	{"bva-inprocess", new intoption(&bva_inprocess, 0, 1000000, "Apply BVA during search every N restarts, doubling N after each run (0: never)")},
+	{"bve",         new booloption(&bve, "{Apply Bounded Variable Elimination (BVE) before BVA}")},
+	{"bve-occ-limit", new intoption(&bve_occ_limit, 0, 100000, "BVE only eliminates variables with at most this many occurrences per polarity")},
+	{"subsume",     new booloption(&subsume_pre, "{Apply subsumption and self-subsuming resolution before BVE and BVA}")},
+	{"subsume-learnts", new intoption(&subsume_learnts, 0, 1000000, "Subsume and strengthen the learnt clauses every N restarts (0: never)")},
+	{"card",        new intoption(&card_bound, 0, 3, "Replace at-most-k constraints in the binomial encoding (every k+1 of the literals in a clause), e.g. pairwise at-most-one, with native constraints, for k up to N (0: never)")},
+	{"xor",         new intoption(&xor_size, 0, 8, "Recover XOR constraints of up to N variables from their clauses, and propagate them together by Gauss-Jordan elimination (0: never). Not with -proof: its reasons are not RUP")},
+	{"probe",       new intoption(&probe_interval, 0, 1000000, "Probe failed literals and substitute equivalent literals before the search and every N restarts (0: never)")},
+	{"pre",         new stringoption(&pre_passes, "Preprocessing passes in order, e.g. \"up,bva:50,up\" (pass[:effort], passes: " + BVA::Pipeline::names() + "). Overrides -subsume, -bve and -bva")},
 	{"bva-export",  new stringoption(&bva_export_path, "Export cnf to the specified file after BVA")},
 };
 
@@ -32,6 +80,10 @@ unordered_map<string, option*> options = {
 
 int main(int argc, char** argv){
 	parse_options(argc, argv);
+#ifdef NDEBUG
+	if (check_interval)
+		Abort("-check needs a debug or checked build", 2);
+#endif
 	ifstream in (argv[argc - 1]);
 	if (!in.good())
 		Abort("cannot read input file", 1);
@@ -40,19 +92,35 @@ int main(int argc, char** argv){
 		S.set_proof_file(out);
 	}
 	TIME_BLOCK("[   EDUSAT   ] Solve");
-	if (preprocess) {
-		BVA::AutomatedReencoder processor(S.proof_tracer);
+	if (pre_passes.empty()) { // the passes selected by the older flags
+		for (auto [flag, pass] : {pair<int, const char *>{subsume_pre, "subsume"}, {bve, "bve"}, {preprocess, "bva"}})
+			if (flag)
+				pre_passes += (pre_passes.empty() ? "" : ",") + string(pass);
+	}
+	BVA::Pipeline pipeline;
+	string error;
+	if (!pipeline.parse(pre_passes, error))
+		Abort("-pre: " + error, 2);
+	if (!pipeline.empty()) {
+		vector<int> clauses, units, extension;
+		int max_var;
 		{
+			BVA::AutomatedReencoder processor(S.proof_tracer);
 			TIME_BLOCK("[   EDUSAT   ] Preprocessing");
-			processor.setIterations(bva_length);
+			configure_reencoder(processor);
 			processor.readCNF(in);
-			processor.applySimpleBVA();
+			pipeline.run(processor);
 			if (!bva_export_path.empty())
 				processor.writeDimacsCNF(bva_export_path.c_str());
+			max_var = processor.maxVar();
+			processor.exportExtension(extension);
+			// Clause::header_size - 1 slots are reserved for the watches and search position
+			processor.exportCNF(clauses, units, Clause::header_size - 1, v2l);
 		}
 		{
 			TIME_BLOCK("[   EDUSAT   ] Reading CNF");
-			S.read_cnf(processor.getCNF(), processor.maxVar());
+			S.read_cnf(clauses, units, max_var);
+			S.set_extension(extension);
 		}
 	} else {
 		TIME_BLOCK("[   EDUSAT   ] Reading CNF");
@@ -0,0 +1,196 @@
+#include "gauss.h"
+#include "watch_search.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
+
+void row_xor_scalar(uint64_t *dst, const uint64_t *src, int words)
+{
+	for (int i = 0; i < words; ++i)
+		dst[i] ^= src[i];
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+void row_xor_avx2(uint64_t *dst, const uint64_t *src, int words)
+{
+	int i = 0;
+	for (; i + 4 <= words; i += 4)
+	{
+		const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(d, s));
+	}
+	row_xor_scalar(dst + i, src + i, words - i);
+}
+#else
+void row_xor_avx2(uint64_t *dst, const uint64_t *src, int words)
+{
+	row_xor_scalar(dst, src, words);
+}
+#endif
+
+const RowXor xor_rows = has_avx2() ? row_xor_avx2 : row_xor_scalar;
+
+const char *row_xor_kernel()
+{
+	return has_avx2() ? "avx2" : "scalar";
+}
+
+bool GaussMatrix::build(size_t max_bits)
+{
+	for (auto &x : xors)
+		col_var.insert(col_var.end(), x.first.begin(), x.first.end());
+	sort(col_var.begin(), col_var.end());
+	col_var.erase(unique(col_var.begin(), col_var.end()), col_var.end());
+	rhs_col = static_cast<int>(col_var.size());
+	words = rhs_col / 64 + 1;
+	if (xors.size() * words * 64 > max_bits)
+	{
+		xors.clear();
+		col_var.clear();
+		return true;
+	}
+	num_rows = static_cast<int>(xors.size());
+	mat.assign(static_cast<size_t>(num_rows) * words, 0);
+	for (int r = 0; r < num_rows; ++r)
+	{
+		for (Var v : xors[r].first)
+		{
+			const int c = static_cast<int>(lower_bound(col_var.begin(), col_var.end(), v) - col_var.begin());
+			row(r)[c >> 6] ^= 1ull << (c & 63);
+		}
+		if (xors[r].second)
+			row(r)[rhs_col >> 6] ^= 1ull << (rhs_col & 63);
+	}
+	xors.clear();
+	xors.shrink_to_fit();
+
+	// Gauss-Jordan: each row gets a basic column, which is eliminated from the others.
+	// Rows that become empty are dropped.
+	unassigned.assign(words, 0);
+	for (int c = 0; c < rhs_col; ++c)
+		unassigned[c >> 6] |= 1ull << (c & 63);
+	basic.assign(num_rows, -1);
+	int kept = 0;
+	for (int r = 0; r < num_rows; ++r)
+	{
+		const int c = first_of(row(r), unassigned);
+		if (c < 0)
+		{
+			if (bit(row(r), rhs_col))
+				return false; // 0 = 1
+			continue;
+		}
+		if (r != kept)
+			copy(row(r), row(r) + words, row(kept));
+		make_basic(kept, c);
+		++kept;
+	}
+	num_rows = kept;
+	mat.resize(static_cast<size_t>(num_rows) * words);
+	mat.shrink_to_fit();
+	basic.resize(num_rows);
+	is_true.assign(words, 0);
+	return true;
+}
+
+int GaussMatrix::first_of(const uint64_t *r, const vector<uint64_t> &mask) const
+{
+	for (int w = 0; w < words; ++w)
+		if (uint64_t m = r[w] & mask[w])
+			return w * 64 + __builtin_ctzll(m);
+	return -1;
+}
+
+int GaussMatrix::count_of(const uint64_t *r, const vector<uint64_t> &mask) const
+{
+	int n = 0;
+	for (int w = 0; w < words; ++w)
+		n += __builtin_popcountll(r[w] & mask[w]);
+	return n;
+}
+
+void GaussMatrix::make_basic(int r, int c)
+{
+	const uint64_t *src = row(r);
+	for (int k = 0; k < num_rows; ++k)
+		if (k != r && bit(row(k), c))
+			xor_rows(row(k), src, words);
+	basic[r] = c;
+}
+
+void GaussMatrix::load(const signed char *vals)
+{
+	fill(unassigned.begin(), unassigned.end(), 0);
+	fill(is_true.begin(), is_true.end(), 0);
+	for (int c = 0; c < rhs_col; ++c)
+	{
+		const signed char val = vals[v2l(col_var[c])];
+		if (!val)
+			unassigned[c >> 6] |= 1ull << (c & 63);
+		else if (val > 0)
+			is_true[c >> 6] |= 1ull << (c & 63);
+	}
+	is_true[rhs_col >> 6] |= 1ull << (rhs_col & 63);
+}
+
+void GaussMatrix::false_lits(int r, Var skip, clause_t &out) const
+{
+	const uint64_t *w = row(r);
+	for (int i = 0; i < words; ++i)
+		for (uint64_t m = w[i]; m; m &= m - 1)
+		{
+			const int c = i * 64 + __builtin_ctzll(m);
+			if (c == rhs_col || col_var[c] == skip)
+				continue;
+			const Var v = col_var[c];
+			out.push_back(static_cast<Lit>(bit(is_true.data(), c) ? v2l(-v) : v2l(v)));
+		}
+}
+
+bool GaussMatrix::propagate(const signed char *vals, vector<clause_t> &implied, clause_t &conflict)
+{
+	load(vals);
+	for (int r = 0; r < num_rows; ++r)
+		if (!bit(unassigned.data(), basic[r]))
+		{
+			const int c = first_of(row(r), unassigned);
+			if (c >= 0)
+				make_basic(r, c);
+		}
+	for (int r = 0; r < num_rows; ++r)
+	{
+		const int n = count_of(row(r), unassigned);
+		if (n > 1)
+			continue;
+		const bool odd = count_of(row(r), is_true) & 1; // of the assigned variables and the right-hand side
+		if (n == 0)
+		{
+			if (!odd)
+				continue;
+			conflict.clear();
+			false_lits(r, 0, conflict);
+			return false;
+		}
+		const Var v = col_var[basic[r]]; // the only unassigned column
+		implied.push_back({static_cast<Lit>(odd ? v2l(v) : v2l(-v))});
+		false_lits(r, v, implied.back());
+	}
+	return true;
+}
+
+bool GaussMatrix::propagated(const signed char *vals)
+{
+	if (empty())
+		return true; // no rows, and no columns to load
+	load(vals);
+	for (int r = 0; r < num_rows; ++r)
+	{
+		const int n = count_of(row(r), unassigned);
+		if (n == 1 || (n == 0 && (count_of(row(r), is_true) & 1)))
+			return false;
+	}
+	return true;
+}
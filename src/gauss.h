@@ -0,0 +1,60 @@
+#pragma once
+#include "edusat-header.h"
+
+// dst ^= src, over 'words' 64-bit words
+typedef void (*RowXor)(uint64_t *dst, const uint64_t *src, int words);
+
+void row_xor_scalar(uint64_t *dst, const uint64_t *src, int words);
+void row_xor_avx2(uint64_t *dst, const uint64_t *src, int words); // only if the CPU has AVX2
+
+// The fastest kernel the CPU supports, chosen once at startup by CPUID
+extern const RowXor xor_rows;
+const char *row_xor_kernel(); // its name
+
+// XOR constraints (x1 ^ ... ^ xn = rhs) as the rows of a bit-packed matrix over
+// GF(2), kept in reduced row echelon form: each row has a basic column, which is
+// in no other row. Row operations do not change the solutions, so the matrix
+// never has to be undone on backtracking. propagate() only moves the basic
+// column of a row to an unassigned one when its own is assigned. Then a row
+// with no unassigned column is either satisfied or a conflict, a row with one
+// implies its basic variable, and no sum of rows implies anything more, since
+// it has the unassigned basic columns of all of them.
+class GaussMatrix {
+	int num_rows, words; // words per row: the columns of the variables, then the right-hand side
+	int rhs_col;
+	vector<Var> col_var;	// column => variable
+	vector<uint64_t> mat;	// num_rows rows of 'words' words
+	vector<int> basic;		// row => its basic column
+	vector<uint64_t> unassigned, is_true; // columns by the current assignment. The right-hand side is true
+	vector<pair<vector<Var>, bool>> xors; // added, until build()
+
+	uint64_t *row(int r) { return mat.data() + static_cast<size_t>(r) * words; }
+	const uint64_t *row(int r) const { return mat.data() + static_cast<size_t>(r) * words; }
+	static bool bit(const uint64_t *w, int c) { return w[c >> 6] >> (c & 63) & 1; }
+	// The first column of 'r' that is also in 'mask' (the right-hand side is not), or -1
+	int first_of(const uint64_t *r, const vector<uint64_t> &mask) const;
+	int count_of(const uint64_t *r, const vector<uint64_t> &mask) const;
+	void make_basic(int r, int c); // column c becomes the basic column of row r
+	void load(const signed char *vals);
+	// The literals of the variables of row r that are false, except that of 'skip'
+	void false_lits(int r, Var skip, clause_t &out) const;
+
+public:
+	GaussMatrix() : num_rows(0), words(0), rhs_col(0) {}
+	void add_xor(const vector<Var> &vars, bool rhs) { xors.push_back({vars, rhs}); }
+	// Eliminates the added XORs into the matrix. Returns false if they contradict
+	// each other. If the matrix would have more than max_bits, it stays empty.
+	bool build(size_t max_bits);
+	bool empty() const { return num_rows == 0; }
+	int rows() const { return num_rows; }
+	int cols() const { return rhs_col; }
+	size_t memory() const { return mat.capacity() * sizeof(uint64_t); }
+
+	// At a fixpoint of BCP. 'vals' maps literals to 1 if true, -1 if false and 0
+	// if unassigned. Adds a clause to 'implied' for each implied literal: the
+	// literal, then the false literals of its row. Returns false on a conflict,
+	// with the false literals of the row in 'conflict'.
+	bool propagate(const signed char *vals, vector<clause_t> &implied, clause_t &conflict);
+	// True if no row is false or implies a literal, as after propagate() found nothing
+	bool propagated(const signed char *vals);
+};
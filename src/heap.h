@@ -0,0 +1,66 @@
+#pragma once
+#include "edusat-header.h"
+
+// A binary max-heap of variables, ordered by a score vector owned by the caller.
+// Each variable is in the heap at most once. After the score of a variable in
+// the heap changes, update() restores the order.
+class VarHeap {
+	const vector<double>& score;
+	vector<Var> heap;
+	vector<int> pos; // var => index into heap. -1 if not in it
+
+	bool before(Var a, Var b) const { return score[a] > score[b]; }
+	void place(int i, Var v) { heap[i] = v; pos[v] = i; }
+	void up(int i) {
+		Var v = heap[i];
+		for (; i > 0 && before(v, heap[(i - 1) / 2]); i = (i - 1) / 2)
+			place(i, heap[(i - 1) / 2]);
+		place(i, v);
+	}
+	void down(int i) {
+		Var v = heap[i];
+		const int n = static_cast<int>(heap.size());
+		while (2 * i + 1 < n) {
+			int child = 2 * i + 1;
+			if (child + 1 < n && before(heap[child + 1], heap[child]))
+				++child;
+			if (!before(heap[child], v))
+				break;
+			place(i, heap[child]);
+			i = child;
+		}
+		place(i, v);
+	}
+public:
+	explicit VarHeap(const vector<double>& s) : score(s) {}
+	void grow(unsigned int nvars) { pos.resize(nvars + 1, -1); }
+	bool empty() const { return heap.empty(); }
+	bool contains(Var v) const { return pos[v] >= 0; }
+	Var top() const { return heap[0]; }
+	void insert(Var v) {
+		Assert(!contains(v));
+		heap.push_back(v);
+		up(static_cast<int>(heap.size()) - 1);
+	}
+	Var pop() {
+		Var v = heap[0];
+		pos[v] = -1;
+		Var last = heap.back();
+		heap.pop_back();
+		if (!heap.empty()) {
+			place(0, last);
+			down(0);
+		}
+		return v;
+	}
+	bool consistent() const { // the heap order and pos agree. For checking
+		for (int i = 0; i < static_cast<int>(heap.size()); ++i)
+			if (pos[heap[i]] != i || (i > 0 && before(heap[i], heap[(i - 1) / 2])))
+				return false;
+		return true;
+	}
+	void update(Var v) {
+		up(pos[v]);
+		down(pos[v]);
+	}
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include "edusat-header.h"
+
+// The settings that the hot path (BCP, analyze, backtrack, decide) branches on.
+// The solver's hot functions are templates on a policy: the search loop is
+// instantiated once per combination of StaticPolicy, chosen in Solver::_solve(),
+// so that the branches on these settings are constant and compiled away. Code
+// outside the search loop (reading, inprocessing, probing) uses DynamicPolicy.
+template <VAR_DEC_HEURISTIC VarDH, VAL_DEC_HEURISTIC ValDH, bool Proof, bool Verbose>
+struct StaticPolicy {
+	static constexpr VAR_DEC_HEURISTIC var_dh() { return VarDH; }
+	static constexpr VAL_DEC_HEURISTIC val_dh() { return ValDH; }
+	static constexpr bool proof() { return Proof; } // false: never notify the proof tracer
+	static constexpr bool verbose() { return Verbose; } // verbose_now()
+};
+
+// Reads the same settings from the command-line options.
+struct DynamicPolicy {
+	static VAR_DEC_HEURISTIC var_dh() { return VarDecHeuristic; }
+	static VAL_DEC_HEURISTIC val_dh() { return ValDecHeuristic; }
+	static bool proof() { return true; } // if there is a proof tracer
+	static bool verbose() { return verbose_now(); }
+};
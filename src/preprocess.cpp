@@ -0,0 +1,99 @@
+#include "preprocess.h"
+#include "profiler.h"
+
+namespace BVA
+{
+    // The passes are methods of the reencoder
+    static const struct
+    {
+        const char *name;
+        void (AutomatedReencoder::*method)();
+    } known_passes[] = {
+        {"up", &AutomatedReencoder::applyUnitPropagation},
+        {"pure", &AutomatedReencoder::applyPureLiterals},
+        {"subsume", &AutomatedReencoder::applySubsumption},
+        {"bve", &AutomatedReencoder::applyBVE},
+        {"bva", &AutomatedReencoder::applySimpleBVA},
+        {"strash", &AutomatedReencoder::applyStrash},
+    };
+
+    class MethodPass : public Pass
+    {
+        const char *pass_name;
+        void (AutomatedReencoder::*method)();
+
+    public:
+        MethodPass(const char *name, void (AutomatedReencoder::*method)(), double effort)
+            : Pass(effort), pass_name(name), method(method) {}
+        const char *name() const override { return pass_name; }
+        void apply(AutomatedReencoder &reencoder) override { (reencoder.*method)(); }
+    };
+
+    string Pipeline::names()
+    {
+        string res;
+        for (const auto &pass : known_passes)
+            res += (res.empty() ? "" : ", ") + string(pass.name);
+        return res;
+    }
+
+    bool Pipeline::parse(const string &spec, string &error)
+    {
+        passes.clear();
+        stringstream ss(spec);
+        string item;
+        while (getline(ss, item, ','))
+        {
+            const size_t colon = item.find(':');
+            const string name = item.substr(0, colon);
+            double effort = -1;
+            if (colon != string::npos)
+            {
+                try
+                {
+                    size_t end;
+                    effort = stod(item.substr(colon + 1), &end);
+                    if (end != item.size() - colon - 1 || effort < 0)
+                        throw invalid_argument(item);
+                }
+                catch (...)
+                {
+                    error = "bad effort in '" + item + "'";
+                    return false;
+                }
+            }
+            auto known = find_if(begin(known_passes), end(known_passes), [&](const auto &pass)
+                                 { return name == pass.name; });
+            if (known == end(known_passes))
+            {
+                error = "unknown pass '" + name + "' (known: " + names() + ")";
+                return false;
+            }
+            passes.push_back(make_unique<MethodPass>(known->name, known->method, effort));
+        }
+        return true;
+    }
+
+    void Pipeline::run(AutomatedReencoder &reencoder)
+    {
+        Profiler &profiler = Profiler::getInstance();
+        profiler.addOperation("preprocessing");
+        profiler.start("preprocessing");
+        const double default_effort = reencoder.getEffort();
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            Pass &pass = *passes[i];
+            const string op = to_string(i + 1) + ". " + pass.name();
+            const size_t before = reencoder.getCNF().size();
+            reencoder.setEffort(pass.effort < 0 ? default_effort : pass.effort);
+            profiler.addOperation(op);
+            profiler.start(op);
+            pass.apply(reencoder);
+            profiler.stop(op);
+            profiler.addCount(op, (int64_t)before - (int64_t)reencoder.getCNF().size());
+        }
+        reencoder.setEffort(default_effort);
+        profiler.stop("preprocessing");
+        profiler.printAllStatistics();
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <memory>
+#include "bva.h"
+
+namespace BVA
+{
+    // A preprocessing pass over the clauses held by an AutomatedReencoder,
+    // which is the clause store shared by all the passes of a pipeline.
+    class Pass
+    {
+    public:
+        explicit Pass(double effort) : effort(effort) {}
+        virtual ~Pass() = default;
+        virtual const char *name() const = 0;
+        virtual void apply(AutomatedReencoder &) = 0;
+
+        double effort; // step budget per literal of the formula, < 0: the reencoder's own
+    };
+
+    // A sequence of passes, given as a comma separated list of pass names,
+    // each one optionally followed by ':' and its effort, e.g. "up,bva:50,up".
+    // The time of every pass and the # of clauses it removed are reported
+    // through the Profiler.
+    class Pipeline
+    {
+        vector<unique_ptr<Pass>> passes;
+
+    public:
+        static string names(); // the known pass names
+        bool parse(const string &spec, string &error);
+        bool empty() const { return passes.empty(); }
+        void run(AutomatedReencoder &);
+    };
+};
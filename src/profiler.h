@@ -4,6 +4,8 @@
 #include <chrono>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip> // for formatting (setw, setprecision, left, etc.)
@@ -19,6 +21,7 @@ public:
     void addOperation(const std::string& operationName) {
         if (totalTimes.find(operationName) == totalTimes.end()) {
             totalTimes[operationName] = 0.0;
+            operationNames.push_back(operationName);
         }
     }
 
@@ -45,6 +48,11 @@ public:
         startTimes.erase(it);
     }
 
+    // Accumulate a count reported with the operation, e.g. # of clauses removed
+    void addCount(const std::string& operationName, int64_t count) {
+        counts[operationName] += count;
+    }
+
     // Retrieve total elapsed time for a single operation
     double getTotalTime(const std::string& operationName) const {
         auto it = totalTimes.find(operationName);
@@ -78,13 +86,15 @@ public:
                   << std::setw(25) << "Operation"
                   << std::setw(15) << "Time (s)"
                   << std::setw(20) << "% of preprocessing"
+                  << "Clauses removed"
                   << "\n";
 
         // Print a separator line
-        std::cout << std::string(25 + 15 + 20, '-') << "\n";
+        std::cout << std::string(25 + 15 + 20 + 15, '-') << "\n";
 
         // Print each operation's stats
-        for (const auto& [opName, opTime] : totalTimes) {
+        for (const auto& opName : operationNames) {
+            double opTime = totalTimes.at(opName);
             // Percentage of preprocessing
             double percentagePreproc = (preprocessingTime > 0.0)
                                           ? (opTime / preprocessingTime * 100.0)
@@ -94,8 +104,11 @@ public:
             std::cout << std::left
                       << std::setw(25) << opName
                       << std::setw(15) << opTime
-                      << std::setw(20) << preprocStr
-                      << "\n";
+                      << std::setw(20) << preprocStr;
+            auto countIt = counts.find(opName);
+            if (countIt != counts.end())
+                std::cout << countIt->second;
+            std::cout << "\n";
         }
         std::cout << "\n=====================================================\n\n";
 
@@ -111,10 +124,14 @@ private:
     Profiler(const Profiler&) = delete;
     Profiler& operator=(const Profiler&) = delete;
 
+    // Operation names in the order they were added, for printing
+    std::vector<std::string> operationNames;
     // Map: operation name -> total accumulated time in seconds
     std::unordered_map<std::string, double> totalTimes;
     // Map: operation name -> last start time point
     std::unordered_map<std::string, std::chrono::high_resolution_clock::time_point> startTimes;
+    // Map: operation name -> accumulated count
+    std::unordered_map<std::string, int64_t> counts;
 };
 
 // Macros for convenience
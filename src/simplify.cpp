@@ -0,0 +1,155 @@
+#include "bva.h"
+
+// Unit propagation and pure literal elimination on the reencoder's clauses.
+// Both are cheap and mostly clean up for the other passes: units left by the
+// input or produced by subsumption, and literals that BVE or BVA left in one
+// polarity only.
+
+namespace BVA
+{
+    // Removes 'c' from the formula, its occurrence lists included.
+    void AutomatedReencoder::disconnect(Clause *c)
+    {
+        for (int lit : *c)
+        {
+            Occs &os = occs(lit);
+            stats.simp_steps += os.size();
+            os.erase(std::find(os.begin(), os.end(), c));
+        }
+        if (proof)
+            proof->notify_deleted_clause(c->literals());
+        cnf.erase(c);
+        arena.release(c);
+    }
+
+    void AutomatedReencoder::applyUnitPropagation()
+    {
+        TIME_BLOCK("[PREPROCESSOR] Unit Propagation");
+        int64_t formula_size;
+        {
+            TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
+            formula_size = connectOccurrences();
+        }
+        vector<int> units;
+        for (Clause *c : cnf)
+            if (unary(c))
+                units.push_back((*c)[0]);
+
+        const int64_t max_steps = effort > 0 ? stats.simp_steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const char *limit_reached = nullptr;
+        for (size_t i = 0; i < units.size() && !limit_reached; ++i)
+        {
+            const int unit = units[i];
+            // Satisfied clauses, but the unit itself
+            for (size_t j = 0; j < occs(unit).size();)
+            {
+                Clause *c = occs(unit)[j];
+                if (unary(c))
+                {
+                    j++;
+                    continue;
+                }
+                disconnect(c);
+                stats.satisfied++;
+            }
+            // Clauses with the negation lose it
+            while (!occs(-unit).empty())
+            {
+                if (stats.simp_steps > max_steps)
+                {
+                    limit_reached = "effort";
+                    break;
+                }
+                Clause *c = occs(-unit).back();
+                if (unary(c))
+                    break; // conflicting units, left to the solver
+                resolvent.clear();
+                for (int lit : *c)
+                    if (lit != -unit)
+                        resolvent.push_back(lit);
+                Clause *d = arena.allocate(resolvent);
+                if (proof)
+                    proof->notify_added_clause(resolvent, false /*learnt*/);
+                disconnect(c);
+                stats.falsified++;
+                if (find(*d))
+                {
+                    if (proof)
+                        proof->notify_deleted_clause(resolvent);
+                    arena.release(d);
+                    continue;
+                }
+                cnf.insert(d);
+                for (int lit : *d)
+                    occs(lit).push_back(d);
+                if (unary(d))
+                    units.push_back((*d)[0]);
+            }
+            stats.units++;
+        }
+
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
+        else
+            cout << " -> Algorithm ended" << endl;
+
+        cout << "[PREPROCESSOR] Statistics:" << endl;
+        cout << "[PREPROCESSOR]    " << stats.units << " units propagated" << endl;
+        cout << "[PREPROCESSOR]    " << stats.satisfied << " satisfied clauses removed" << endl;
+        cout << "[PREPROCESSOR]    " << stats.falsified << " false literals removed" << endl;
+        cout << "[PREPROCESSOR]    " << cnf.size() << " clauses remaining" << endl;
+    }
+
+    // A literal whose negation does not occur satisfies all its clauses. They
+    // are removed and saved on the extension stack with the literal as witness,
+    // the same way as the clauses eliminated by BVE.
+    void AutomatedReencoder::applyPureLiterals()
+    {
+        TIME_BLOCK("[PREPROCESSOR] Pure Literals");
+        int64_t formula_size;
+        {
+            TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
+            formula_size = connectOccurrences();
+        }
+        vector<int> candidates;
+        for (int v = 1; v <= max_var; ++v)
+            candidates.push_back(v);
+
+        const int64_t max_steps = effort > 0 ? stats.simp_steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const char *limit_reached = nullptr;
+        while (!candidates.empty())
+        {
+            if (stats.simp_steps > max_steps)
+            {
+                limit_reached = "effort";
+                break;
+            }
+            const int v = candidates.back();
+            candidates.pop_back();
+            if (occs(v).empty() == occs(-v).empty())
+                continue; // not pure or does not occur
+            const int lit = occs(v).empty() ? -v : v;
+            while (!occs(lit).empty())
+            {
+                Clause *c = occs(lit).back();
+                extension.push_back(0);
+                extension.insert(extension.end(), c->begin(), c->end());
+                extension.push_back(lit);
+                for (int other : *c)
+                    if (other != lit && occs(other).size() == 1)
+                        candidates.push_back(vidx(other)); // -other may become pure
+                disconnect(c);
+            }
+            stats.pure++;
+        }
+
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
+        else
+            cout << " -> Algorithm ended" << endl;
+
+        cout << "[PREPROCESSOR] Statistics:" << endl;
+        cout << "[PREPROCESSOR]    " << stats.pure << " pure literals" << endl;
+        cout << "[PREPROCESSOR]    " << cnf.size() << " clauses remaining" << endl;
+    }
+};
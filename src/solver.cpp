@@ -50,7 +50,7 @@ void Solver::read_cnf(ifstream &in)
 	int i;
 	unsigned int vars, clauses, unary = 0;
 	set<Lit> s;
-	Clause c;
+	clause_t c;
 
 	while (in.peek() == 'c')
 		skipLine(in);
@@ -72,8 +72,8 @@ void Solver::read_cnf(ifstream &in)
 		i = parseInt(in);
 		if (i == 0)
 		{
-			c.cl().resize(s.size());
-			copy(s.begin(), s.end(), c.cl().begin());
+			c.resize(s.size());
+			copy(s.begin(), s.end(), c.begin());
 			switch (c.size())
 			{
 			case 0:
@@ -84,11 +84,11 @@ void Solver::read_cnf(ifstream &in)
 			}
 			case 1:
 			{
-				Lit l = c.cl()[0];
+				Lit l = c[0];
 				// checking if we have conflicting unaries. Sufficiently rare to check it here rather than
 				// add a check in BCP.
-				if (state[l2v(l)] != VarState::V_UNASSIGNED)
-					if (Neg(l) != (state[l2v(l)] == VarState::V_FALSE))
+				if (value(l2v(l)) != VarState::V_UNASSIGNED)
+					if (Neg(l) != (value(l2v(l)) == VarState::V_FALSE))
 					{
 						print_stats();
 						Abort("UNSAT (conflicting unaries for var " + to_string(l2v(l)) + ")", 0);
@@ -100,7 +100,7 @@ void Solver::read_cnf(ifstream &in)
 			default:
 				add_clause(c, 0, 1, true /*original*/);
 			}
-			c.reset();
+			c.clear();
 			s.clear();
 			continue;
 		}
@@ -115,72 +115,80 @@ void Solver::read_cnf(ifstream &in)
 	}
 	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
 		reset_iterators();
+	first_learnt = cnf.top();
+	if (xor_size)
+		extract_xors();
+	if (card_bound)
+		extract_cardinality();
 }
 
-void Solver::read_cnf(const unordered_set<BVA::Clause *, BVA::ClauseHasher> &cnf_, const int max_var)
+// Adopts a formula that is already in the clause DB layout (see ClauseDB::adopt),
+// e.g. as exported by BVA::AutomatedReencoder. The clause literals are neither
+// copied nor re-sorted, and 'clauses' is left empty.
+void Solver::read_cnf(vector<int> &clauses, const vector<Lit> &units, const int max_var)
 {
-	set<Lit> s;
-	Clause c;
-
-	const int num_clauses = cnf_.size();
-	if (!max_var || !num_clauses)
-		Abort("Expecting non-zero variables and clauses", 1);
-	cnf.reserve(num_clauses);
+	// No clauses is fine here, e.g. when preprocessing eliminated all of them.
+	if (!max_var)
+		Abort("Expecting non-zero variables", 1);
 
 	set_nvars(max_var);
-	set_nclauses(num_clauses);
 	initialize();
+	cnf.adopt(clauses);
+	set_nclauses(cnf.size() + units.size());
 
-	int idx, elit;
-	for (const auto &c_ : cnf_)
+	for (int idx : cnf)
 	{
-		assert(c_);
-		for (int lit : *c_)
+		Clause &c = cnf[idx];
+		for (Lit *it = c.begin(); it != c.end(); ++it)
 		{
-			idx = abs(lit);
-			if (idx > max_var)
+			if (l2v(*it) > max_var)
 				Abort("Literal index larger than declared on the first line", 1);
+			// Scores are accumulated here and inserted into m_Score2Vars once, below.
 			if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
-				bumpVarScore(idx);
-			elit = v2l(lit);
+				m_activity[l2v(*it)] += m_var_inc;
 			if (ValDecHeuristic == VAL_DEC_HEURISTIC::LITSCORE)
-				bumpLitScore(elit);
-			s.insert(elit);
-		}
-		c.cl().resize(s.size());
-		copy(s.begin(), s.end(), c.cl().begin());
-		switch (c.size())
-		{
-		case 0:
-		{
-			stringstream num;																  // this allows to convert int to string
-			num << cnf_size() + 1;															  // converting int to string.
-			Abort("Empty clause not allowed in input formula (clause " + num.str() + ")", 1); // concatenating strings
+				bumpLitScore(*it);
 		}
-		case 1:
+		watches.push_back(c.lit(0), idx);
+		watches.push_back(c.lit(1), idx);
+		if (proof_tracer)
+			proof_tracer->notify_added_clause(c.get_raw_copy(), true /*original*/);
+	}
+
+	for (Lit l : units)
+	{
+		if (l2v(l) > max_var)
+			Abort("Literal index larger than declared on the first line", 1);
+		if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+			m_activity[l2v(l)] += m_var_inc;
+		if (ValDecHeuristic == VAL_DEC_HEURISTIC::LITSCORE)
+			bumpLitScore(l);
+		// checking if we have conflicting unaries.
+		if (value(l2v(l)) != VarState::V_UNASSIGNED)
 		{
-			Lit l = c.cl()[0];
-			// checking if we have conflicting unaries. Sufficiently rare to check it here rather than
-			// add a check in BCP.
-			if (state[l2v(l)] != VarState::V_UNASSIGNED)
-				if (Neg(l) != (state[l2v(l)] == VarState::V_FALSE))
-				{
-					print_stats();
-					Abort("UNSAT (conflicting unaries for var " + to_string(l2v(l)) + ")", 0);
-				}
-			assert_lit(l);
-			add_unary_clause(l, true /*original*/);
-			break; // unary clause. Note we do not add it as a clause.
-		}
-		default:
-			add_clause(c, 0, 1, true /*original*/);
+			if (Neg(l) != (value(l2v(l)) == VarState::V_FALSE))
+			{
+				print_stats();
+				Abort("UNSAT (conflicting unaries for var " + to_string(l2v(l)) + ")", 0);
+			}
+			continue; // duplicated unary
 		}
-		c.reset();
-		s.clear();
-		continue;
+		assert_lit(l);
+		add_unary_clause(l, true /*original*/);
 	}
+
 	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	{
+		for (Var v = 1; v <= max_var; ++v)
+			if (m_activity[v] > 0)
+				m_Score2Vars[m_activity[v]].insert(v);
 		reset_iterators();
+	}
+	first_learnt = cnf.top();
+	if (xor_size)
+		extract_xors();
+	if (card_bound)
+		extract_cardinality();
 }
 
 #pragma endregion readCNF
@@ -199,21 +207,21 @@ void Solver::reset()
 inline void Solver::reset_iterators(double where)
 {
 	m_Score2Vars_it = (where == 0) ? m_Score2Vars.begin() : m_Score2Vars.lower_bound(where);
+	m_should_reset_iterators = false;
+	if (m_Score2Vars.empty())
+		return; // no variable occurs in a clause
 	Assert(m_Score2Vars_it != m_Score2Vars.end());
 	m_VarsSameScore_it = m_Score2Vars_it->second.begin();
-	m_should_reset_iterators = false;
 }
 
 void Solver::initialize()
 {
 
-	state.resize(nvars + 1, VarState::V_UNASSIGNED);
-	prev_state.resize(nvars + 1, VarState::V_FALSE); // we set initial assignment with phase-saving to false.
-	antecedent.resize(nvars + 1, -1);
-	marked.resize(nvars + 1);
-	dlevel.resize(nvars + 1);
+	vars.resize(nvars + 1); // we set initial assignment with phase-saving to false.
+	unit_logged.resize(nvars + 1);
 
 	nlits = 2 * nvars;
+	vals.resize(nlits + 1 + Vals_padding);
 	watches.resize(nlits + 1);
 	LitScore.resize(nlits + 1);
 	// initialize scores
@@ -223,20 +231,82 @@ void Solver::initialize()
 	{
 		m_activity[v] = 0;
 	}
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::VMTF)
+	{
+		vmtf_prev.resize(nvars + 1);
+		vmtf_next.resize(nvars + 1);
+		vmtf_stamp.resize(nvars + 1);
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			vmtf_enqueue(v);
+	}
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::LRB)
+		grow_lrb(0);
+	target_phase.resize(nvars + 1, VarState::V_UNASSIGNED);
+	best_phase.resize(nvars + 1, VarState::V_UNASSIGNED);
+	next_rephase = rephase_interval;
+	num_rephases = 0;
+	stable = stable_mode == 2;
+	mode_length = Mode_length_init;
+	next_mode_switch = stable_mode == 1 ? mode_length : INT_MAX;
+	restart_conflicts = stable_restarts = 0;
+	next_inprocess = inprocess_interval = bva_inprocess;
+	next_subsume = subsume_learnts;
+	next_probe = 0; // before the search
+	next_remove = root_assigned = 0;
+	next_check = 0;
 	reset();
 }
 
+// Makes room for the variables up to new_nvars, e.g. auxiliary variables
+// introduced by inprocessing. The new variables are unassigned.
+void Solver::grow_vars(unsigned int new_nvars)
+{
+	Assert(new_nvars >= nvars);
+	unsigned int old_nvars = nvars;
+	nvars = new_nvars;
+	nlits = 2 * nvars;
+	vals.resize(nlits + 1 + Vals_padding);
+	vars.resize(nvars + 1);
+	unit_logged.resize(nvars + 1);
+	watches.resize(nlits + 1);
+	if (!card_occs.empty())
+		card_occs.resize(nlits + 1);
+	LitScore.resize(nlits + 1);
+	m_activity.resize(nvars + 1, 0);
+	// decide() only sees variables that have a score.
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+		for (Var v = old_nvars + 1; v <= static_cast<Var>(nvars); ++v)
+			bumpVarScore(v);
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::VMTF)
+	{
+		vmtf_prev.resize(nvars + 1);
+		vmtf_next.resize(nvars + 1);
+		vmtf_stamp.resize(nvars + 1);
+		for (Var v = old_nvars + 1; v <= static_cast<Var>(nvars); ++v)
+			vmtf_enqueue(v);
+	}
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::LRB)
+		grow_lrb(old_nvars);
+	target_phase.resize(nvars + 1, VarState::V_UNASSIGNED);
+	best_phase.resize(nvars + 1, VarState::V_UNASSIGNED);
+}
+
+template <class P>
 inline void Solver::assert_lit(Lit l)
 {
 	trail.push_back(l);
 	int var = l2v(l);
-	if (Neg(l))
-		prev_state[var] = state[var] = VarState::V_FALSE;
-	else
-		prev_state[var] = state[var] = VarState::V_TRUE;
-	dlevel[var] = dl;
+	vals[l] = 1;
+	vals[::negate(l)] = -1;
+	vars[var].phase = Neg(l) ? VarState::V_FALSE : VarState::V_TRUE;
+	vars[var].level = dl;
+	if (P::var_dh() == VAR_DEC_HEURISTIC::LRB)
+	{
+		lrb_assigned[var] = num_learned;
+		lrb_participated[var] = lrb_reasoned[var] = 0;
+	}
 	++num_assignments;
-	if (verbose_now())
+	if (P::verbose())
 		cout << l2rl(l) << " @ " << dl << endl;
 }
 
@@ -263,29 +333,32 @@ void Solver::m_rescaleScores(double &new_score)
 	tmp_map.swap(m_Score2Vars);
 }
 
+template <class P>
 ClauseState Solver::next_not_false(Clause &c, bool is_left_watch, Lit other_watch, bool binary, int &loc)
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "next_not_false" << endl;
 
 	if (!binary)
-		for (clause_t::iterator it = c.begin(); it != c.end(); ++it)
-		{
-			LitState LitState = lit_state(*it, get_lit_state(*it));
-			if (LitState != LitState::L_UNSAT && *it != other_watch)
-			{ // found another watch_lit
-				loc = distance(c.begin(), it);
-				if (is_left_watch)
-					c.lw_set(loc); // if literal was the left one
-				else
-					c.rw_set(loc); // if literal was the right one
-				return ClauseState::C_UNDEF;
-			}
+	{ // with -circular-watch, from where the last search stopped (Gent, JAIR 2013)
+		const int sz = static_cast<int>(c.size()), pos = circular_watch ? c.get_pos() : 0;
+		loc = find_not_false(c.begin(), pos, sz, vals.data(), other_watch);
+		if (loc == sz && (loc = find_not_false(c.begin(), 0, pos, vals.data(), other_watch)) == pos)
+			loc = sz;
+		if (loc < sz)
+		{ // found another watch_lit
+			c.pos_set(loc);
+			if (is_left_watch)
+				c.lw_set(loc); // if literal was the left one
+			else
+				c.rw_set(loc); // if literal was the right one
+			return ClauseState::C_UNDEF;
 		}
-	switch (lit_state(other_watch, get_lit_state(other_watch)))
+	}
+	switch (lit_state(other_watch))
 	{
 	case LitState::L_UNSAT: // conflict
-		if (verbose_now())
+		if (P::verbose())
 		{
 			c.print_real_lits();
 			cout << " is conflicting" << endl;
@@ -306,13 +379,12 @@ void Solver::bumpVarScore(int var_idx)
 	double new_score;
 	double score = m_activity[var_idx];
 
-	if (score > 0)
-	{
-		Assert(m_Score2Vars.find(score) != m_Score2Vars.end());
-		m_Score2Vars[score].erase(var_idx);
-		if (m_Score2Vars[score].size() == 0)
-			m_Score2Vars.erase(score);
-	}
+	// A score of 0 is either no score yet, or one that rescaling took below the
+	// smallest double: then the variable is in m_Score2Vars under 0.
+	auto old_it = m_Score2Vars.find(score);
+	Assert(score == 0 || old_it != m_Score2Vars.end());
+	if (old_it != m_Score2Vars.end() && old_it->second.erase(var_idx) && old_it->second.empty())
+		m_Score2Vars.erase(old_it);
 	new_score = score + m_var_inc;
 	m_activity[var_idx] = new_score;
 
@@ -333,35 +405,139 @@ void Solver::bumpLitScore(int lit_idx)
 	LitScore[lit_idx]++;
 }
 
-void Solver::add_clause(Clause &c, int l, int r, bool original)
+// Makes room for the variables after old_nvars in the LRB data, with score 0.
+void Solver::grow_lrb(unsigned int old_nvars)
+{
+	lrb_q.resize(nvars + 1);
+	lrb_assigned.resize(nvars + 1);
+	lrb_participated.resize(nvars + 1);
+	lrb_reasoned.resize(nvars + 1);
+	lrb_canceled.resize(nvars + 1, num_learned);
+	lrb_heap.grow(nvars);
+	for (Var v = old_nvars + 1; v <= static_cast<Var>(nvars); ++v)
+		lrb_heap.insert(v);
+}
+
+void Solver::lrb_unassigned(Var v)
+{
+	const int interval = num_learned - lrb_assigned[v];
+	if (interval > 0)
+	{
+		const double rate = static_cast<double>(lrb_participated[v] + lrb_reasoned[v]) / interval;
+		lrb_q[v] = (1 - lrb_alpha) * lrb_q[v] + lrb_alpha * rate;
+	}
+	lrb_canceled[v] = num_learned;
+	if (lrb_heap.contains(v))
+		lrb_heap.update(v);
+	else
+		lrb_heap.insert(v);
+}
+
+// The reason side rate extension: the variables in the reasons of the literals
+// of the learnt clause, that are not in it themselves, are counted as well.
+void Solver::lrb_reason_side(const clause_t &learnt)
+{
+	for (Lit l : learnt)
+		vars[l2v(l)].seen = true;
+	for (Lit l : learnt)
+	{
+		Var v = l2v(l);
+		if (!vars[v].level || vars[v].reason == -1)
+			continue; // the antecedents of level-0 variables may be gone
+		Clause &c = reason_clause(vars[v].reason, ::negate(l));
+		for (Lit *it = c.begin(); it != c.end(); ++it)
+		{
+			Var w = l2v(*it);
+			if (vars[w].seen)
+				continue;
+			vars[w].seen = true;
+			lrb_seen.push_back(w);
+			++lrb_reasoned[w];
+		}
+	}
+	for (Lit l : learnt)
+		vars[l2v(l)].seen = false;
+	for (Var w : lrb_seen)
+		vars[w].seen = false;
+	lrb_seen.clear();
+}
+
+// Appends v to the VMTF queue, as the most recently bumped variable.
+void Solver::vmtf_enqueue(Var v)
+{
+	vmtf_prev[v] = vmtf_last;
+	vmtf_next[v] = 0;
+	if (vmtf_last)
+		vmtf_next[vmtf_last] = v;
+	else
+		vmtf_first = v;
+	vmtf_last = v;
+	vmtf_stamp[v] = ++vmtf_stamps;
+	if (value(v) == VarState::V_UNASSIGNED)
+		vmtf_search = v;
+}
+
+void Solver::vmtf_dequeue(Var v)
+{
+	if (vmtf_prev[v])
+		vmtf_next[vmtf_prev[v]] = vmtf_next[v];
+	else
+		vmtf_first = vmtf_next[v];
+	if (vmtf_next[v])
+		vmtf_prev[vmtf_next[v]] = vmtf_prev[v];
+	else
+		vmtf_last = vmtf_prev[v];
+	if (vmtf_search == v) // the variables after v are assigned
+		vmtf_search = vmtf_prev[v] ? vmtf_prev[v] : vmtf_next[v];
+}
+
+// Moves the variables seen by analyze() to the end of the queue. They keep
+// their relative order, so the ones bumped most recently before stay ahead.
+void Solver::vmtf_bump_analyzed()
+{
+	sort(vmtf_bumped.begin(), vmtf_bumped.end(), [&](Var a, Var b)
+		 { return vmtf_stamp[a] < vmtf_stamp[b]; });
+	for (Var v : vmtf_bumped)
+	{
+		if (v == vmtf_last)
+			continue;
+		vmtf_dequeue(v);
+		vmtf_enqueue(v);
+	}
+	vmtf_bumped.clear();
+}
+
+template <class P>
+void Solver::add_clause(clause_t &c, int l, int r, bool original)
 {
 	Assert(c.size() > 1);
-	c.lw_set(l);
-	c.rw_set(r);
-	int loc = static_cast<int>(cnf.size()); // the first is in location 0 in cnf
+	int loc = cnf.add(c, l, r); // the index of the clause in cnf
 	int size = c.size();
 
-	watches[c.lit(l)].push_back(loc);
-	watches[c.lit(r)].push_back(loc);
-	cnf.push_back(c);
-	if (proof_tracer)
-		proof_tracer->notify_added_clause(c.get_raw_copy(), original);
+	watches.push_back(c[l], loc);
+	watches.push_back(c[r], loc);
+	if (P::proof() && proof_tracer)
+		proof_tracer->notify_added_clause(cnf[loc].get_raw_copy(), original);
 }
 
+template <class P>
 void Solver::add_unary_clause(Lit l, bool original)
 {
 	unaries.push_back(l);
-	if (proof_tracer)
+	if (P::proof() && proof_tracer)
 		proof_tracer->notify_added_clause({l2rl(l)}, original);
 }
 
-int Solver ::getVal(Var v)
+template <class P>
+int Solver::getVal(Var v)
 {
-	switch (ValDecHeuristic)
+	switch (P::val_dh())
 	{
 	case VAL_DEC_HEURISTIC::PHASESAVING:
 	{
-		VarState saved_phase = prev_state[v];
+		VarState saved_phase = vars[v].phase;
+		if ((target_phases == 2 || (target_phases == 1 && stable)) && target_phase[v] != VarState::V_UNASSIGNED)
+			saved_phase = target_phase[v];
 		switch (saved_phase)
 		{
 		case VarState::V_FALSE:
@@ -384,14 +560,15 @@ int Solver ::getVal(Var v)
 	return 0;
 }
 
+template <class P>
 SolverState Solver::decide()
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "decide" << endl;
 	Lit best_lit = 0;
 	int max_score = 0;
 	Var bestVar = 0;
-	switch (VarDecHeuristic)
+	switch (P::var_dh())
 	{
 
 	case VAR_DEC_HEURISTIC::MINISAT:
@@ -411,11 +588,11 @@ SolverState Solver::decide()
 				v = *m_VarsSameScore_it;
 				++m_VarsSameScore_it;
 				++cnt;
-				if (state[v] == VarState::V_UNASSIGNED)
+				if (value(v) == VarState::V_UNASSIGNED)
 				{ // found a var to assign
 					m_curr_activity = m_Score2Vars_it->first;
 					assert(m_curr_activity == m_activity[v]);
-					best_lit = getVal(v);
+					best_lit = getVal<P>(v);
 					goto Apply_decision;
 				}
 			}
@@ -426,6 +603,42 @@ SolverState Solver::decide()
 		}
 		break;
 	}
+	case VAR_DEC_HEURISTIC::VMTF:
+	{
+		Var v = vmtf_search;
+		while (v && value(v) != VarState::V_UNASSIGNED)
+			v = vmtf_prev[v];
+		if (!v)
+			break;
+		vmtf_search = v;
+		best_lit = getVal<P>(v);
+		goto Apply_decision;
+	}
+	case VAR_DEC_HEURISTIC::LRB:
+	{
+		while (!lrb_heap.empty())
+		{
+			Var v = lrb_heap.top();
+			if (value(v) != VarState::V_UNASSIGNED)
+			{
+				lrb_heap.pop();
+				continue;
+			}
+			// The locality extension: the scores of the unassigned variables decay
+			// at every conflict. It is applied lazily, when they reach the top.
+			const int age = num_learned - lrb_canceled[v];
+			if (age > 0)
+			{
+				lrb_q[v] *= pow(Lrb_locality_decay, age);
+				lrb_canceled[v] = num_learned;
+				lrb_heap.update(v);
+				continue;
+			}
+			best_lit = getVal<P>(v);
+			goto Apply_decision;
+		}
+		break;
+	}
 	default:
 		Assert(0);
 	}
@@ -448,119 +661,271 @@ Apply_decision:
 		conflicts_at_dl[dl] = num_learned;
 	}
 
-	assert_lit(best_lit);
+	assert_lit<P>(best_lit);
+	vars[l2v(best_lit)].reason = -1;
 	++num_decisions;
 	return SolverState::UNDEF;
 }
 
-void Solver::test()
-{ // tests that each clause is watched twice.
-	for (unsigned int idx = 0; idx < cnf.size(); ++idx)
+// Fails with a message if an invariant of the solver state does not hold.
+// Run at a BCP fixpoint (no conflict, qhead == trail.size()) every -check
+// conflicts in debug and checked builds. Linear in the size of the clause DB.
+void Solver::check_invariants()
+{
+	auto check = [&](bool cond, const string &what)
+	{
+		if (cond)
+			return;
+		cout << "Invariant violated after " << num_learned << " conflicts: " << what << endl;
+		exit(1);
+	};
+	Assert(qhead == trail.size() && conflicting_clause_idx < 0);
+
+	// trail and levels
+	vector<bool> on_trail(nvars + 1, false);
+	for (size_t i = 0, d = 0; i < trail.size(); ++i)
 	{
-		Clause c = cnf[idx];
+		const Lit l = trail[i];
+		const Var v = l2v(l);
+		while (d < static_cast<size_t>(dl) && i >= static_cast<size_t>(separators[d + 1]))
+			++d; // trail[i] is in the segment of level d
+		check(vals[l] == 1 && vals[::negate(l)] == -1, "trail literal " + to_string(l2rl(l)) + " is not true");
+		check(!on_trail[v], "variable " + to_string(v) + " is on the trail twice");
+		on_trail[v] = true;
+		const VarInfo &info = vars[v];
+		// after chronological backtracking lower levels may be mixed into a segment
+		check(chrono_threshold ? info.level <= static_cast<int>(d) : info.level == static_cast<int>(d),
+			  "variable " + to_string(v) + " has level " + to_string(info.level) + " in the segment of level " + to_string(d));
+		if (info.level == 0)
+			continue; // the antecedents of level-0 variables may be gone
+		if (info.reason == -1)
+		{
+			check(static_cast<int>(i) == separators[info.level], "decision " + to_string(v) + " is not at the start of its level");
+			continue;
+		}
+		Clause &c = reason_clause(info.reason, l);
 		bool found = false;
-		for (int zo = 0; zo <= 1; ++zo)
+		for (Lit *it = c.begin(); it != c.end(); ++it)
+			if (*it == l)
+				found = true;
+			else
+				check(vals[*it] < 0 && vars[l2v(*it)].level <= info.level, "the reason of " + to_string(v) + " is not unit");
+		check(found, "the reason of " + to_string(v) + " does not contain it");
+	}
+	// restart() drops the level-0 literals that are already propagated from the trail
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		check(vals[v2l(v)] == -vals[v2l(-v)] && (on_trail[v] || !vals[v2l(v)] || vars[v].level == 0),
+			  "the values of variable " + to_string(v) + " do not match the trail");
+
+	// watches: each clause is in the lists of exactly its two watched literals,
+	// and a false watch has a true partner
+	vector<unsigned char> times_watched(cnf.top(), 0);
+	for (Lit l = 1; l <= static_cast<Lit>(nlits); ++l)
+		for (int idx : watches[l])
+		{
+			check(idx >= 0 && idx < cnf.top(), "watch list of " + to_string(l2rl(l)) + " has a bad clause index");
+			Clause &c = cnf[idx];
+			check(c.get_lw_lit() == l || c.get_rw_lit() == l, "clause " + to_string(idx) + " is in the watch list of " + to_string(l2rl(l)) + " but does not watch it");
+			++times_watched[idx];
+		}
+	for (int idx : cnf)
+	{
+		Clause &c = cnf[idx];
+		check(c.get_lw() != c.get_rw() && c.get_lw() < static_cast<int>(c.size()) && c.get_rw() < static_cast<int>(c.size()),
+			  "clause " + to_string(idx) + " has bad watches");
+		check(times_watched[idx] == 2, "clause " + to_string(idx) + " is in " + to_string(times_watched[idx]) + " watch lists");
+		const Lit lw = c.get_lw_lit(), rw = c.get_rw_lit();
+		check((vals[lw] >= 0 || vals[rw] > 0) && (vals[rw] >= 0 || vals[lw] > 0), "clause " + to_string(idx) + " has a false watch without a true one");
+	}
+
+	// cardinality constraints: none is over its bound, and one at its bound has propagated
+	for (size_t ci = 0; ci < cards.size(); ++ci)
+	{
+		const Card &c = cards[ci];
+		int num_true = 0, num_unassigned = 0;
+		for (Lit l : c.lits)
 		{
-			for (vector<int>::iterator it = watches[c.cl()[zo]].begin(); !found && it != watches[c.cl()[zo]].end(); ++it)
+			num_true += vals[l] > 0;
+			num_unassigned += vals[l] == 0;
+		}
+		check(num_true <= c.bound, "constraint " + to_string(ci) + " has more than " + to_string(c.bound) + " true literals");
+		check(num_true < c.bound || !num_unassigned, "constraint " + to_string(ci) + " is at its bound with unassigned literals");
+	}
+
+	// XOR constraints: no row of the matrix is false or implies a literal
+	check(gauss.propagated(vals.data()), "an XOR constraint is false or unit after BCP");
+
+	// the order of the decision heuristic
+	switch (VarDecHeuristic)
+	{
+	case VAR_DEC_HEURISTIC::MINISAT:
+	{
+		vector<bool> scored(nvars + 1, false);
+		for (auto &entry : m_Score2Vars)
+			for (Var v : entry.second)
 			{
-				if (*it == idx)
-				{
-					found = true;
-					break;
-				}
+				check(m_activity[v] == entry.first, "variable " + to_string(v) + " is under a wrong score");
+				check(!scored[v], "variable " + to_string(v) + " is in the score map twice");
+				scored[v] = true;
 			}
-		}
-		if (!found)
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			check(scored[v] || m_activity[v] == 0, "variable " + to_string(v) + " has a score but is not in the score map");
+		break;
+	}
+	case VAR_DEC_HEURISTIC::VMTF:
+	{
+		unsigned int n = 0;
+		bool after_search = false;
+		for (Var v = vmtf_first, prev = 0; v; prev = v, v = vmtf_next[v], ++n)
 		{
-			cout << "idx = " << idx << endl;
-			c.print();
-			cout << endl;
-			cout << c.size();
+			check(vmtf_prev[v] == prev && (!prev || vmtf_stamp[prev] < vmtf_stamp[v]), "the VMTF queue is broken at " + to_string(v));
+			check(!after_search || value(v) != VarState::V_UNASSIGNED, "unassigned variable " + to_string(v) + " after vmtf_search");
+			after_search = after_search || v == vmtf_search;
 		}
-		Assert(found);
+		check(n == nvars, "the VMTF queue does not have every variable");
+		break;
 	}
+	case VAR_DEC_HEURISTIC::LRB:
+		check(lrb_heap.consistent(), "the LRB heap is not ordered");
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			check(value(v) != VarState::V_UNASSIGNED || lrb_heap.contains(v), "unassigned variable " + to_string(v) + " is not in the LRB heap");
+		break;
+	}
+}
+
+// Propagates the XOR constraints (see GaussMatrix::propagate()). Like those of
+// the cardinality constraints, the implied literals are asserted at dl. Their
+// reasons and the conflict are kept in xor_reasons.
+template <class P>
+void Solver::gauss_propagate()
+{
+	xor_implied.clear();
+	if (!gauss.propagate(vals.data(), xor_implied, xor_conflict))
+	{
+		conflicting_clause_idx = xor_reason(xor_reasons.add(xor_conflict, 0, 1));
+		return;
+	}
+	for (const clause_t &c : xor_implied)
+	{
+		assert_lit<P>(c[0]);
+		vars[l2v(c[0])].reason = xor_reason(xor_reasons.add(c, 0, 1));
+	}
+	if (P::verbose() && !xor_implied.empty())
+		cout << "gauss: " << xor_implied.size() << " implications" << endl;
 }
 
+template <class P>
 SolverState Solver::BCP()
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "BCP" << endl;
-	if (verbose_now())
+	if (P::verbose())
 		cout << "qhead = " << qhead << " trail-size = " << trail.size() << endl;
 	while (qhead < trail.size())
 	{
 		Lit NegatedLit = ::negate(trail[qhead++]);
-		Assert(lit_state(NegatedLit, get_lit_state(NegatedLit)) == LitState::L_UNSAT);
-		if (verbose_now())
+		Assert(vals[NegatedLit] < 0);
+		if (P::verbose())
 			cout << "propagating " << l2rl(::negate(NegatedLit)) << endl;
-		vector<int> new_watch_list;								 // The original watch list minus those clauses that changed a watch. The order is maintained.
-		int new_watch_list_idx = watches[NegatedLit].size() - 1; // Since we are traversing the watch_list backwards, this index goes down.
-		new_watch_list.resize(watches[NegatedLit].size());
-		for (vector<int>::reverse_iterator it = watches[NegatedLit].rbegin(); it != watches[NegatedLit].rend() && conflicting_clause_idx < 0; ++it)
+		if (qhead < trail.size()) // the watch list of the next literal, while this one is processed
+			Prefetch(watches.data(::negate(trail[qhead])));
+		// The cardinality constraints of the true literal count their true literals.
+		// At the bound, the rest are false.
+		if (!card_occs.empty())
+			for (int ci : card_occs[::negate(NegatedLit)])
+			{
+				const Card &card = cards[ci];
+				int num_true = 0;
+				for (Lit l : card.lits)
+					num_true += vals[l] > 0;
+				if (num_true < card.bound)
+					continue;
+				if (num_true > card.bound)
+				{
+					conflicting_clause_idx = card_reason(ci);
+					break;
+				}
+				for (Lit l : card.lits)
+					if (!vals[l])
+					{ // at dl even with -chrono, so that its explanation stays the same while it is assigned
+						assert_lit<P>(::negate(l));
+						vars[l2v(l)].reason = card_reason(ci);
+					}
+			}
+		// The watch list is traversed backwards and compacted in place: the clauses that
+		// keep their watch are moved up to 'kept', in their order. The others are removed.
+		const int n = watches.size(NegatedLit);
+		int kept = n, i = n - 1;
+		int *ws = watches.data(NegatedLit);
+		for (; i >= 0 && conflicting_clause_idx == -1; --i)
 		{
-			Clause &c = cnf[*it];
+			if (i >= Prefetch_distance)
+				Prefetch(&cnf[ws[i - Prefetch_distance]]);
+			const int idx = ws[i];
+			Clause &c = cnf[idx];
 			Lit l_watch = c.get_lw_lit(),
 				r_watch = c.get_rw_lit();
 			bool binary = c.size() == 2;
 			bool is_left_watch = (l_watch == NegatedLit);
 			Lit other_watch = is_left_watch ? r_watch : l_watch;
 			int NewWatchLocation;
-			ClauseState res = next_not_false(c, is_left_watch, other_watch, binary, NewWatchLocation);
+			ClauseState res = next_not_false<P>(c, is_left_watch, other_watch, binary, NewWatchLocation);
 			if (res != ClauseState::C_UNDEF)
-				new_watch_list[new_watch_list_idx--] = *it; // in all cases but the move-watch_lit case we leave watch_lit where it is
+				ws[--kept] = idx; // in all cases but the move-watch_lit case we leave watch_lit where it is
 			switch (res)
 			{
-			case ClauseState::C_UNSAT:
-			{ // conflict
-				if (verbose_now())
+			case ClauseState::C_UNSAT: // conflict
+				if (P::verbose())
 					print_state();
-				if (dl == 0)
-					return SolverState::UNSAT;
-				conflicting_clause_idx = *it;							 // this will also break the loop
-				int dist = distance(it, watches[NegatedLit].rend()) - 1; // # of entries in watches[NegatedLit] that were not yet processed when we hit this conflict.
-				// Copying the remaining watched clauses:
-				for (int i = dist - 1; i >= 0; i--)
-				{
-					new_watch_list[new_watch_list_idx--] = watches[NegatedLit][i];
-				}
-				if (verbose_now())
-					cout << "conflict" << endl;
+				conflicting_clause_idx = idx; // this will also break the loop
 				break;
-			}
 			case ClauseState::C_SAT:
-				if (verbose_now())
+				if (P::verbose())
 					cout << "clause is sat" << endl;
 				break; // nothing to do when clause has a satisfied literal.
 			case ClauseState::C_UNIT:
 			{ // new implication
-				if (verbose_now())
+				if (P::verbose())
 					cout << "propagating: ";
-				assert_lit(other_watch);
-				antecedent[l2v(other_watch)] = *it;
-				if (verbose_now())
+				assert_lit<P>(other_watch);
+				vars[l2v(other_watch)].reason = idx;
+				if (chrono_threshold) // the other literals may all be below dl
+					vars[l2v(other_watch)].level = max_level(c, other_watch);
+				if (P::verbose())
 					cout << "new implication <- " << l2rl(other_watch) << endl;
 				break;
 			}
 			default: // replacing watch_lit
 				Assert(NewWatchLocation < static_cast<int>(c.size()));
 				int new_lit = c.lit(NewWatchLocation);
-				watches[new_lit].push_back(*it);
-				if (verbose_now())
+				watches.push_back(new_lit, idx);
+				ws = watches.data(NegatedLit); // the push_back() may have moved the pool
+				if (P::verbose())
 				{
 					c.print_real_lits();
 					cout << " now watched by " << l2rl(new_lit) << endl;
 				}
 			}
 		}
-		// resetting the list of clauses watched by this literal.
-		watches[NegatedLit].clear();
-		new_watch_list_idx++; // just because of the redundant '--' at the end.
-		watches[NegatedLit].insert(watches[NegatedLit].begin(), new_watch_list.begin() + new_watch_list_idx, new_watch_list.end());
+		// The entries before i + 1 were not processed because of a conflict. The kept ones follow them.
+		copy(ws + kept, ws + n, ws + i + 1);
+		watches.shrink(NegatedLit, i + 1 + n - kept);
+		// At the fixpoint of the clauses and cardinality constraints, the XOR
+		// constraints are propagated together. The clauses propagate their implications.
+		if (qhead == trail.size() && conflicting_clause_idx == -1 && !gauss.empty())
+			gauss_propagate<P>();
 
-		// print_watches();
-		if (conflicting_clause_idx >= 0)
+		if (conflicting_clause_idx != -1)
+		{
+			if (dl == 0 || (chrono_threshold && max_level(reason_clause(conflicting_clause_idx)) == 0))
+			{
+				conflicting_clause_idx = -1;
+				return SolverState::UNSAT;
+			}
+			if (P::verbose())
+				cout << "conflict" << endl;
 			return SolverState::CONFLICT;
-		new_watch_list.clear();
+		}
 	}
 	return SolverState::UNDEF;
 }
@@ -568,8 +933,8 @@ SolverState Solver::BCP()
 /*******************************************************************************************************************
 name: analyze
 input:	1) conflicting clause
-		2) dlevel
-		3) marked
+		2) the levels (VarInfo::level)
+		3) the marks (VarInfo::seen)
 
 assumes: 1) no clause should have the same literal twice. To guarantee this we read through a set in read_cnf.
 			Wihtout this assumption it may loop forever because we may remove only one copy of the pivot.
@@ -577,39 +942,69 @@ assumes: 1) no clause should have the same literal twice. To guarantee this we r
 This is Alg. 1 from "HaifaSat: a SAT solver based on an Abstraction/Refinement model"
 ********************************************************************************************************************/
 
-int Solver::analyze(const Clause conflicting)
+template <class P>
+int Solver::analyze(int conflicting_idx)
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "analyze" << endl;
-	Clause current_clause = conflicting,
-		   new_clause;
+	Clause *current_clause = &reason_clause(conflicting_idx);
+	Lit resolved = 0; // the literal of current_clause that is resolved on. 0 for the conflicting clause.
+	clause_t new_clause;
 	int resolve_num = 0,
 		bktrk = 0,
 		watch_lit = 0, // points to what literal in the learnt clause should be watched, other than the asserting one
 		antecedents_idx = 0;
 
-	Lit u;
-	Var v;
+	Lit u = 0;
+	Var v = 0;
+	if (chrono_threshold)
+	{ // after a chronological backtrack the conflict may be below dl
+		int conflict_level = 0, num_at_level = 0;
+		Lit forced = 0;
+		for (Lit *it = current_clause->begin(); it != current_clause->end(); ++it)
+		{
+			int c_dl = vars[l2v(*it)].level;
+			if (c_dl > conflict_level)
+				conflict_level = c_dl, num_at_level = 0, forced = *it;
+			if (c_dl == conflict_level)
+				++num_at_level;
+		}
+		if (conflict_level < dl)
+			unassign_above<P>(conflict_level);
+		if (num_at_level == 1 && conflicting_idx >= 0)
+		{ // a missed implication: the clause is unit below conflict_level. A constraint is learnt as its clause instead
+			asserted_lit = forced;
+			asserted_level = max_level(*current_clause, forced);
+			asserted_antecedent = conflicting_idx;
+			return asserted_level ? dl - 1 : 0;
+		}
+	}
 	trail_t::reverse_iterator t_it = trail.rbegin();
 	do
 	{
-		for (clause_it it = current_clause.cl().begin(); it != current_clause.cl().end(); ++it)
+		for (Lit *it = current_clause->begin(); it != current_clause->end(); ++it)
 		{
 			Lit lit = *it;
+			if (lit == resolved)
+				continue;
 			v = l2v(lit);
-			if (!marked[v])
+			if (!vars[v].seen)
 			{
-				marked[v] = true;
-				if (dlevel[v] == dl)
+				vars[v].seen = true;
+				if (P::var_dh() == VAR_DEC_HEURISTIC::VMTF)
+					vmtf_bumped.push_back(v);
+				else if (P::var_dh() == VAR_DEC_HEURISTIC::LRB)
+					++lrb_participated[v];
+				if (vars[v].level == dl)
 					++resolve_num;
 				else
 				{ // literals from previos decision levels (roots) are entered to the learned clause.
-					new_clause.insert(lit);
-					if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+					new_clause.push_back(lit);
+					if (P::var_dh() == VAR_DEC_HEURISTIC::MINISAT)
 						bumpVarScore(v);
-					if (ValDecHeuristic == VAL_DEC_HEURISTIC::LITSCORE)
+					if (P::val_dh() == VAL_DEC_HEURISTIC::LITSCORE)
 						bumpLitScore(lit);
-					int c_dl = dlevel[v];
+					int c_dl = vars[v].level;
 					if (c_dl > bktrk)
 					{
 						bktrk = c_dl;
@@ -624,40 +1019,52 @@ int Solver::analyze(const Clause conflicting)
 			u = *t_it;
 			v = l2v(u);
 			++t_it;
-			if (marked[v])
+			if (vars[v].seen && vars[v].level == dl) // with chronological backtracking lower levels may be mixed in
 				break;
 		}
-		marked[v] = false;
+		vars[v].seen = false;
 		--resolve_num;
 		if (!resolve_num)
 			continue;
-		int ant = antecedent[v];
-		current_clause = cnf[ant];
-		current_clause.cl().erase(find(current_clause.cl().begin(), current_clause.cl().end(), u));
+		int ant = vars[v].reason;
+		current_clause = &reason_clause(ant, u);
+		resolved = u;
 	} while (resolve_num > 0);
-	for (clause_it it = new_clause.cl().begin(); it != new_clause.cl().end(); ++it)
-		marked[l2v(*it)] = false;
+	for (clause_it it = new_clause.begin(); it != new_clause.end(); ++it)
+		vars[l2v(*it)].seen = false;
 	Lit Negated_u = ::negate(u);
-	new_clause.cl().push_back(Negated_u);
-	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	new_clause.push_back(Negated_u);
+	if (P::var_dh() == VAR_DEC_HEURISTIC::MINISAT)
 		m_var_inc *= 1 / var_decay; // increasing importance of participating variables.
+	if (P::var_dh() == VAR_DEC_HEURISTIC::VMTF)
+		vmtf_bump_analyzed();
+	if (P::var_dh() == VAR_DEC_HEURISTIC::LRB)
+	{
+		lrb_reason_side(new_clause);
+		if (lrb_alpha > Lrb_alpha_min)
+			lrb_alpha -= Lrb_alpha_step;
+	}
 
 	++num_learned;
 	asserted_lit = Negated_u;
+	asserted_level = bktrk;
 	if (new_clause.size() == 1)
 	{ // unary clause
-		add_unary_clause(Negated_u);
+		add_unary_clause<P>(Negated_u);
 	}
 	else
 	{
-		add_clause(new_clause, watch_lit, new_clause.size() - 1);
+		add_clause<P>(new_clause, watch_lit, new_clause.size() - 1);
 	}
+	asserted_antecedent = cnf.last();
 
-	if (verbose_now())
+	if (P::verbose())
 	{
 		cout << "Learned clause #" << cnf_size() + unaries.size() << ". ";
-		new_clause.print_real_lits();
-		cout << endl;
+		cout << "(";
+		for (clause_it it = new_clause.begin(); it != new_clause.end(); ++it)
+			cout << l2rl(*it) << " ";
+		cout << ")" << endl;
 		cout << " learnt clauses:  " << num_learned;
 		cout << " Backtracking to level " << bktrk << endl;
 	}
@@ -666,79 +1073,260 @@ int Solver::analyze(const Clause conflicting)
 	{
 		cout << "Learned: " << num_learned << " clauses" << endl;
 	}
+	// Chronological backtracking (Nadel and Ryvchin, SAT 2018): instead of a long
+	// jump that would mostly be propagated again, go back one level and assert
+	// the literal out of order, at level bktrk. Units still go to level 0.
+	if (chrono_threshold && bktrk > 0 && dl - bktrk > chrono_threshold && num_learned > Chrono_min_conflicts)
+		return dl - 1;
 	return bktrk;
 }
 
+template <class P>
 void Solver::backtrack(int k)
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "backtrack" << endl;
-	// local restart means that we restart if the number of conflicts learned in this
-	// decision level has passed the threshold.
-	if (k > 0 && (num_learned - conflicts_at_dl[k] > restart_threshold))
-	{ // "local restart"
-		restart();
+	update_target_and_best();
+	if (restart_due(k))
+	{
+		restart<P>();
 		return;
 	}
-	static int counter = 0;
+	unassign_above<P>(k);
+	if (P::verbose())
+		print_state();
+	assert_lit<P>(asserted_lit);
+	vars[l2v(asserted_lit)].level = asserted_level;
+	vars[l2v(asserted_lit)].reason = asserted_antecedent;
+	conflicting_clause_idx = -1;
+}
 
-	for (trail_t::iterator it = trail.begin() + separators[k + 1]; it != trail.end(); ++it)
-	{ // erasing from k+1
-		Var v = l2v(*it);
-		if (dlevel[v])
-		{ // we need the condition because of learnt unary clauses. In that case we enforce an assignment with dlevel = 0.
-			state[v] = VarState::V_UNASSIGNED;
-			if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
-				m_curr_activity = max(m_curr_activity, m_activity[v]);
+// Unassigns the variables above level k. After chronological backtracking, the
+// trail above separators[k + 1] may have literals of level k or below: they stay
+// and are propagated again, since they may have left a watch in a clause that was
+// satisfied by a literal above level k.
+template <class P>
+void Solver::unassign_above(int k)
+{
+	size_t kept = separators[k + 1];
+	for (size_t i = separators[k + 1]; i < trail.size(); ++i)
+	{
+		Var v = l2v(trail[i]);
+		if (vars[v].level <= k)
+		{
+			trail[kept++] = trail[i];
+			continue;
 		}
+		unassign(v);
+		if (P::var_dh() == VAR_DEC_HEURISTIC::MINISAT)
+			m_curr_activity = max(m_curr_activity, m_activity[v]);
+		unassigned<P>(v);
 	}
-	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	if (P::var_dh() == VAR_DEC_HEURISTIC::MINISAT)
 		m_should_reset_iterators = true;
-	if (verbose_now())
-		print_state();
-	trail.erase(trail.begin() + separators[k + 1], trail.end());
-	qhead = trail.size();
+	trail.resize(kept);
+	qhead = min(qhead, static_cast<unsigned int>(separators[k + 1]));
 	dl = k;
-	assert_lit(asserted_lit);
-	antecedent[l2v(asserted_lit)] = cnf.size() - 1;
-	conflicting_clause_idx = -1;
+}
+
+// The highest decision level of the literals of c, other than 'except'.
+int Solver::max_level(Clause &c, Lit except)
+{
+	int res = 0;
+	for (Lit *it = c.begin(); it != c.end(); ++it)
+		if (*it != except)
+			res = max(res, vars[l2v(*it)].level);
+	return res;
+}
+
+// The clause that a reason or conflict index stands for: a clause of the DB or
+// of xor_reasons, or the explanation of a cardinality constraint, which is made
+// in 'explanation' and is valid until the next call. It has the negations of the
+// true literals of the constraint, and 'implied' if the constraint is its
+// reason. These are exactly the bound of them that implied it: the rest were
+// false since then.
+Clause &Solver::reason_clause(int idx, Lit implied)
+{
+	if (idx >= 0)
+		return cnf[idx];
+	if (is_xor_reason(idx))
+		return xor_reasons[xor_of(idx)];
+	const Card &c = cards[card_of(idx)];
+	explanation.assign(Clause::header_size, 0);
+	if (implied)
+		explanation.push_back(implied);
+	for (Lit l : c.lits)
+		if (vals[l] > 0)
+			explanation.push_back(::negate(l));
+	explanation[0] = static_cast<int>(explanation.size()) - Clause::header_size;
+	explanation[2] = 1; // rw
+	return *reinterpret_cast<Clause *>(explanation.data());
+}
+
+// Completes the assignment into a model of the formula before preprocessing:
+// unassigned variables are set to false, then the clauses on the extension
+// stack are visited backwards, and the witness of any clause that is not
+// satisfied is flipped.
+void Solver::extend_model(vector<VarState> &model)
+{
+	if (extension.empty())
+		return;
+	for (VarState &s : model)
+		if (s == VarState::V_UNASSIGNED)
+			s = VarState::V_FALSE;
+	for (int i = static_cast<int>(extension.size()) - 1; i >= 0; --i)
+	{
+		Lit witness = extension[i--];
+		bool sat = false;
+		for (; extension[i]; --i)
+			if (!sat)
+				sat = (model[Abs(extension[i])] == VarState::V_TRUE) == (extension[i] > 0);
+		if (!sat)
+			model[Abs(witness)] = witness > 0 ? VarState::V_TRUE : VarState::V_FALSE;
+	}
 }
 
 void Solver::validate_assignment()
 {
 	for (unsigned int i = 1; i <= nvars; ++i)
-		if (state[i] == VarState::V_UNASSIGNED)
+		if (value(i) == VarState::V_UNASSIGNED)
 		{
 			cout << "Unassigned var: " + to_string(i) << endl; // This is supposed to happen only if the variable does not appear in any clause
 		}
-	for (vector<Clause>::iterator it = cnf.begin(); it != cnf.end(); ++it)
+	for (int idx : cnf)
 	{
+		Clause &c = cnf[idx];
 		int found = 0;
-		for (clause_it it_c = it->cl().begin(); it_c != it->cl().end() && !found; ++it_c)
-			if (lit_state(*it_c, get_lit_state(*it_c)) == LitState::L_SAT)
+		for (Lit *it_c = c.begin(); it_c != c.end() && !found; ++it_c)
+			if (lit_state(*it_c) == LitState::L_SAT)
 				found = 1;
 		if (!found)
 		{
 			cout << "fail on clause: ";
-			it->print();
+			c.print();
 			cout << endl;
-			for (clause_it it_c = it->cl().begin(); it_c != it->cl().end() && !found; ++it_c)
-				cout << *it_c << " (" << (int)lit_state(*it_c, get_lit_state(*it_c)) << ") ";
+			for (Lit *it_c = c.begin(); it_c != c.end() && !found; ++it_c)
+				cout << *it_c << " (" << (int)lit_state(*it_c) << ") ";
 			cout << endl;
 			Abort("Assignment validation failed", 3);
 		}
 	}
 	for (vector<Lit>::iterator it = unaries.begin(); it != unaries.end(); ++it)
 	{
-		if (lit_state(*it, get_lit_state(*it)) != LitState::L_SAT)
+		if (lit_state(*it) != LitState::L_SAT)
 			Abort("Assignment validation failed (unaries)", 3);
 	}
+	for (const Card &c : cards)
+		if (count_if(c.lits.begin(), c.lits.end(), [&](Lit l) { return vals[l] > 0; }) > c.bound)
+			Abort("Assignment validation failed (cardinality constraints)", 3);
 	cout << "Assignment validated" << endl;
 }
 
+// The Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... (i starts from 0)
+static int luby(int i)
+{
+	int size = 1, seq = 0;
+	while (size < i + 1)
+	{
+		++seq;
+		size = 2 * size + 1;
+	}
+	while (size - 1 != i)
+	{
+		size = (size - 1) >> 1;
+		--seq;
+		i = i % size;
+	}
+	return 1 << seq;
+}
+
+// Called on backtracking to level k after a conflict. In focused mode this is a
+// local restart: the # of conflicts learned since level k was decided passed the
+// threshold. In stable mode restarts follow the Luby sequence.
+bool Solver::restart_due(int k)
+{
+	if (k == 0)
+		return false;
+	if (stable)
+		return num_learned - restart_conflicts > Stable_restart_unit * luby(stable_restarts);
+	return num_learned - conflicts_at_dl[k] > restart_threshold;
+}
+
+// Called at a conflict at level dl. The trail below dl has no conflict, so if it
+// is the longest so far its values become the target (and best) phases.
+void Solver::update_target_and_best()
+{
+	const int size = separators[dl];
+	if (size > target_size)
+	{
+		target_size = size;
+		for (int i = 0; i < size; ++i)
+			target_phase[l2v(trail[i])] = value(l2v(trail[i]));
+	}
+	if (size > best_size)
+	{
+		best_size = size;
+		for (int i = 0; i < size; ++i)
+			best_phase[l2v(trail[i])] = value(l2v(trail[i]));
+	}
+}
+
+// Resets the saved phases, cycling through the original (false), best, inverted
+// (true), best, random and best phases, and starts new target and best phases.
+// With -walk, each best phase is improved by local search ('W').
+SolverState Solver::rephase()
+{
+	static const char schedule[] = "OBIBRB", walk_schedule[] = "OBWIBWRBW";
+	const string kinds = walk_effort ? walk_schedule : schedule;
+	const char kind = kinds[num_rephases % kinds.size()];
+	++num_rephases;
+	next_rephase = num_learned + rephase_interval * (num_rephases + 1);
+	if (verbose >= 1)
+		cout << "rephase #" << num_rephases << ": " << kind << endl;
+	static mt19937 rng(0);
+	SolverState res = SolverState::UNDEF;
+	if (kind == 'W')
+		res = walk();
+	else
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			switch (kind)
+			{
+			case 'O':
+				vars[v].phase = VarState::V_FALSE;
+				break;
+			case 'I':
+				vars[v].phase = VarState::V_TRUE;
+				break;
+			case 'B':
+				if (best_phase[v] != VarState::V_UNASSIGNED)
+					vars[v].phase = best_phase[v];
+				break;
+			case 'R':
+				vars[v].phase = rng() & 1 ? VarState::V_TRUE : VarState::V_FALSE;
+				break;
+			}
+	fill(target_phase.begin(), target_phase.end(), VarState::V_UNASSIGNED);
+	target_size = best_size = 0;
+	return res;
+}
+
+void Solver::switch_mode()
+{
+	stable = !stable;
+	if (!stable)
+		mode_length *= 2;
+	next_mode_switch = num_learned + mode_length;
+	restart_conflicts = num_learned;
+	stable_restarts = 0;
+	target_size = 0; // each mode has its own target
+	if (verbose >= 1)
+		cout << "switching to " << (stable ? "stable" : "focused") << " mode" << endl;
+}
+
+template <class P>
 void Solver::restart()
 {
-	if (verbose_now())
+	if (P::verbose())
 		cout << "restart" << endl;
 	restart_threshold = static_cast<int>(restart_threshold * restart_multiplier);
 	if (restart_threshold > restart_upper)
@@ -751,17 +1339,29 @@ void Solver::restart()
 	if (verbose >= 1)
 		cout << "restart: new threshold = " << restart_threshold << endl;
 	++num_restarts;
+	restart_conflicts = num_learned;
+	if (stable)
+		++stable_restarts;
 	for (unsigned int i = 1; i <= nvars; ++i)
-		if (dlevel[i] > 0)
+		if (vars[i].level > 0)
 		{
-			state[i] = VarState::V_UNASSIGNED;
-			dlevel[i] = 0;
+			unassign(i);
+			vars[i].level = 0;
+			unassigned<P>(i);
 		}
-	trail.clear();
+	// Level-0 literals assigned out of order (see unassign_above()) are propagated again
+	size_t kept = 0;
+	for (size_t i = separators[1]; i < trail.size(); ++i)
+		if (value(l2v(trail[i])) != VarState::V_UNASSIGNED)
+			trail[kept++] = trail[i];
+	trail.resize(kept);
 	qhead = 0;
 	separators.clear();
 	conflicts_at_dl.clear();
-	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	if (watches.fragmented())
+		watches.defragment();
+	xor_reasons.truncate(0); // only level-0 literals, whose reasons are not read, are left
+	if (P::var_dh() == VAR_DEC_HEURISTIC::MINISAT)
 	{
 		m_curr_activity = 0; // The activity does not really become 0. When it is reset in decide() it becomes the largets activity.
 		m_should_reset_iterators = true;
@@ -769,59 +1369,1080 @@ void Solver::restart()
 	reset();
 }
 
-void Solver::solve()
+bool Solver::satisfied(Clause &c)
 {
-	SolverState res = _solve();
-	Assert(res == SolverState::SAT || res == SolverState::UNSAT || res == SolverState::TIMEOUT);
-	print_stats();
-	switch (res)
-	{
-	case SolverState::SAT:
-	{
-		validate_assignment();
-		string str = "solution in ",
-			   str1 = Assignment_file;
-		cout << str + str1 << endl;
-		cout << "SAT" << endl;
-		break;
-	}
-	case SolverState::UNSAT:
-		cout << "UNSAT" << endl;
-		break;
-	case SolverState::TIMEOUT:
-		cout << "TIMEOUT" << endl;
-		return;
-	default:
+	for (Lit *it = c.begin(); it != c.end(); ++it)
+		if (lit_state(*it) == LitState::L_SAT)
+			return true;
+	return false;
+}
+
+// Adds the level-0 literals to the proof as units, at decision level 0. They justify
+// removing false literals from clauses, also after their reasons are deleted.
+void Solver::log_root_units()
+{
+	Assert(dl == 0);
+	if (!proof_tracer)
 		return;
-	}
-	return;
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		if (value(v) != VarState::V_UNASSIGNED && !unit_logged[v])
+		{
+			proof_tracer->notify_added_clause({value(v) == VarState::V_TRUE ? v : -v}, false);
+			unit_logged[v] = true;
+		}
 }
 
-SolverState Solver::_solve()
+// Applies BVA to the irredundant clauses in the middle of the search. It must be
+// invoked at decision level 0 with BCP completed, so every clause that is not
+// satisfied has at least two unassigned literals. The irredundant clauses are
+// simplified by the level-0 assignment, reencoded, and replace the old ones.
+// Learnt clauses are kept, since the new formula implies the old one.
+void Solver::inprocess()
 {
-	SolverState res;
-	while (true)
+	Assert(dl == 0 && conflicting_clause_idx < 0);
+	TIME_BLOCK("[   EDUSAT   ] Inprocessing");
+	++num_inprocessings;
+	inprocess_interval *= 2;
+	next_inprocess = num_restarts + inprocess_interval;
+
+	log_root_units();
+	vector<int> clauses, units;
+	int new_nvars;
+	{
+		BVA::AutomatedReencoder reencoder(proof_tracer);
+		configure_reencoder(reencoder);
+		reencoder.setMaxVar(nvars);
+		vector<int> lits;
+		for (int idx = 0; idx < first_learnt; idx = cnf.next(idx))
+		{
+			Clause &c = cnf[idx];
+			if (c.is_removed())
+				continue;
+			if (satisfied(c))
+			{
+				if (proof_tracer)
+					proof_tracer->notify_deleted_clause(c.get_raw_copy());
+				continue;
+			}
+			lits.clear();
+			for (Lit *it = c.begin(); it != c.end(); ++it)
+				if (get_lit_state(*it) == VarState::V_UNASSIGNED)
+					lits.push_back(l2rl(*it));
+			Assert(lits.size() > 1);
+			if (proof_tracer && lits.size() < c.size())
+			{
+				proof_tracer->notify_added_clause(lits, false);
+				proof_tracer->notify_deleted_clause(c.get_raw_copy());
+			}
+			if (!reencoder.addClause(lits) && proof_tracer) // tautology or duplicate
+				proof_tracer->notify_deleted_clause(lits);
+		}
+		reencoder.applySimpleBVA();
+		new_nvars = reencoder.maxVar();
+		reencoder.exportCNF(clauses, units, Clause::header_size - 1, v2l);
+	}
+	Assert(units.empty());
+
+	// Learnt clauses move behind the new irredundant ones.
+	vector<clause_t> learnts;
+	collect_clauses(learnts, first_learnt, cnf.top());
+
+	if (verbose >= 1)
+		cout << "inprocessing #" << num_inprocessings << ": " << new_nvars - nvars << " auxiliary variables" << endl;
+	grow_vars(new_nvars);
+	cnf.adopt(clauses);
+	attach_learnts(learnts);
+	subsumed_top = first_learnt; // the learnt clauses moved
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	{
+		m_curr_activity = 0;
+		m_should_reset_iterators = true;
+	}
+}
+
+static vector<int> real_lits(const clause_t &c)
+{
+	vector<int> res;
+	for (Lit l : c)
+		res.push_back(l2rl(l));
+	return res;
+}
+
+// Calls f with every r of the literals of s (r <= s.size()), in their order
+template <class F>
+static void for_each_subset(const vector<Lit> &s, size_t r, F f)
+{
+	vector<size_t> pos(r);
+	clause_t sub(r);
+	for (size_t i = 0; i < r; ++i)
+		pos[i] = i;
+	while (true)
+	{
+		for (size_t i = 0; i < r; ++i)
+			sub[i] = s[pos[i]];
+		f(sub);
+		size_t i = r;
+		while (i > 0 && pos[i - 1] == s.size() - r + i - 1)
+			--i;
+		if (i == 0)
+			return;
+		++pos[i - 1];
+		for (size_t j = i; j < r; ++j)
+			pos[j] = pos[j - 1] + 1;
+	}
+}
+
+// Copies the clauses in cnf[begin, end) out of the DB, at decision level 0 with
+// BCP completed. Satisfied clauses are dropped and false literals removed, so all
+// the literals of the copies are unassigned. Returns how many copies come from
+// below 'top'.
+size_t Solver::collect_clauses(vector<clause_t> &res, int begin, int end, int top)
+{
+	log_root_units();
+	size_t below = 0;
+	clause_t lits;
+	for (int idx = begin; idx < end; idx = cnf.next(idx))
+	{
+		Clause &c = cnf[idx];
+		if (c.is_removed())
+			continue;
+		if (satisfied(c))
+		{
+			if (proof_tracer)
+				proof_tracer->notify_deleted_clause(c.get_raw_copy());
+			continue;
+		}
+		lits.clear();
+		for (Lit *it = c.begin(); it != c.end(); ++it)
+			if (get_lit_state(*it) == VarState::V_UNASSIGNED)
+				lits.push_back(*it);
+		Assert(lits.size() > 1);
+		if (proof_tracer && lits.size() < c.size())
+		{
+			proof_tracer->notify_added_clause(real_lits(lits), false);
+			proof_tracer->notify_deleted_clause(c.get_raw_copy());
+		}
+		res.push_back(lits);
+		if (idx < top)
+			++below;
+	}
+	return below;
+}
+
+// Appends the learnt clauses to the DB, watched by their first two literals,
+// and rebuilds the watch lists of all clauses.
+void Solver::attach_learnts(vector<clause_t> &learnts)
+{
+	first_learnt = cnf.top();
+	for (clause_t &c : learnts)
+		cnf.add(c, 0, 1);
+	watches.clear_all();
+	for (int idx : cnf)
+	{
+		watches.push_back(cnf[idx].get_lw_lit(), idx);
+		watches.push_back(cnf[idx].get_rw_lit(), idx);
+	}
+}
+
+// Removes the clauses that are satisfied at level 0, at decision level 0 with BCP
+// completed, if there are new level-0 variables since the last time. As BCP runs
+// at least as many assignments between two calls as there are literals in the
+// DB, the scans take linear time overall. The removed clauses stay in their
+// watch lists, where they do no harm since level 0 is never undone, until
+// collect_garbage() runs, once they take -gc of the DB.
+void Solver::remove_satisfied()
+{
+	Assert(dl == 0 && conflicting_clause_idx < 0);
+	next_remove = num_assignments + cnf.top();
+	int assigned = 0;
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		if (value(v) != VarState::V_UNASSIGNED)
+			++assigned;
+	if (assigned == root_assigned)
+		return;
+	root_assigned = assigned;
+	log_root_units();
+	for (int idx : cnf)
+	{
+		Clause &c = cnf[idx];
+		if (!satisfied(c))
+			continue;
+		if (proof_tracer)
+			proof_tracer->notify_deleted_clause(c.get_raw_copy());
+		cnf.remove(idx);
+	}
+	if (cnf.wasted() > gc_waste * cnf.top())
+		collect_garbage();
+}
+
+// Compacts the clause DB, at decision level 0: the clauses that are not removed
+// move into a new region, the watch lists drop the removed ones and follow the
+// others, and the old region is freed. analyze() only follows the reasons of
+// the conflict level, so those of the level-0 variables are cleared rather than
+// followed.
+void Solver::collect_garbage()
+{
+	Assert(dl == 0 && conflicting_clause_idx < 0);
+	const size_t before = cnf.memory();
+	{
+		vector<int> old = cnf.compact({&first_learnt, &subsumed_top});
+		for (Lit l = 1; l <= static_cast<Lit>(nlits); ++l)
+		{
+			int *ws = watches.data(l);
+			const int n = watches.size(l);
+			int kept = 0;
+			for (int i = 0; i < n; ++i)
+				if (int idx = ClauseDB::forward(old, ws[i]); idx >= 0)
+					ws[kept++] = idx;
+			watches.shrink(l, kept);
+		}
+	}
+#ifdef __GLIBC__
+	malloc_trim(0); // a large region freed to the heap may stay mapped
+#endif
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		vars[v].reason = -1;
+	asserted_antecedent = -1;
+	if (verbose >= 1)
+		cout << "garbage collection: " << before / 1024 << " KB -> " << cnf.memory() / 1024 << " KB clauses" << endl;
+}
+
+// Replaces at-most-k constraints in the binomial encoding, for k up to -card,
+// with native ones, after reading the formula. A clause (-x1 v ... v -xk+1) is
+// the constraint that at most k of x1..xk+1 are true. It grows greedily by the
+// literals y that are in a clause with every k of its literals, and is kept if
+// it has at least k + 2, i.e. it replaces at least k + 2 clauses. The clauses
+// are removed from the DB but not from the proof: they are the explanations of
+// the constraint (see reason_clause()), so the learnt clauses stay RUP.
+void Solver::extract_cardinality()
+{
+	Assert(dl == 0);
+	const int64_t max_steps = static_cast<int64_t>(Card_effort) * cnf.size();
+	int64_t steps = 0;
+	int num_removed = 0;
+	vector<int> num_of_bound(card_bound + 1);
+	vector<bool> var_mark(nvars + 1);
+	for (int k = 1; k <= card_bound; ++k)
+	{
+		// The clauses of k + 1 literals, as the sorted literals of their constraint
+		map<clause_t, int> clause_of;
+		for (int idx : cnf)
+		{
+			Clause &c = cnf[idx];
+			if (static_cast<int>(c.size()) != k + 1)
+				continue;
+			clause_t key;
+			for (Lit *it = c.begin(); it != c.end(); ++it)
+				key.push_back(::negate(*it));
+			sort(key.begin(), key.end());
+			clause_of.emplace(key, idx);
+		}
+		vector<vector<const clause_t *>> occs(nlits + 1);
+		for (auto &entry : clause_of)
+			for (Lit l : entry.first)
+				occs[l].push_back(&entry.first);
+
+		clause_t sub, key;
+		for (auto &entry : clause_of)
+		{
+			if (steps > max_steps)
+				break;
+			if (cnf[entry.second].is_removed())
+				continue;
+			vector<Lit> lits = entry.first;
+			for (Lit l : lits)
+				var_mark[l2v(l)] = true;
+			// the candidates are in a clause with lits[0]
+			for (const clause_t *d : occs[lits[0]])
+				for (Lit y : *d)
+				{
+					if (var_mark[l2v(y)])
+						continue;
+					bool all = true;
+					for_each_subset(lits, k, [&](const clause_t &t)
+									{
+										if (!all)
+											return;
+										++steps;
+										key = t;
+										key.insert(upper_bound(key.begin(), key.end(), y), y);
+										all = clause_of.count(key);
+									});
+					if (!all)
+						continue;
+					lits.insert(upper_bound(lits.begin(), lits.end(), y), y);
+					var_mark[l2v(y)] = true;
+				}
+			for (Lit l : lits)
+				var_mark[l2v(l)] = false;
+			if (static_cast<int>(lits.size()) < k + 2)
+				continue;
+			for_each_subset(lits, k + 1, [&](const clause_t &t)
+							{
+								Clause &c = cnf[clause_of.at(t)];
+								if (!c.is_removed())
+								{
+									cnf.remove(clause_of.at(t));
+									++num_removed;
+								}
+							});
+			cards.push_back({k, lits});
+			++num_of_bound[k];
+		}
+	}
+	if (cards.empty())
+		return;
+	card_occs.resize(nlits + 1);
+	for (size_t ci = 0; ci < cards.size(); ++ci)
+		for (Lit l : cards[ci].lits)
+			card_occs[l].push_back(ci);
+	collect_garbage();
+	if (verbose >= 1)
+	{
+		cout << "cardinality: " << num_removed << " clauses replaced by " << cards.size() << " constraints (";
+		for (int k = 1; k <= card_bound; ++k)
+			cout << (k > 1 ? ", " : "") << "at most " << k << ": " << num_of_bound[k];
+		cout << ")" << endl;
+	}
+}
+
+// Recovers the XOR constraints of up to -xor variables from their clauses, after
+// reading the formula: x1 ^ ... ^ xn = b is the 2^(n-1) clauses over x1..xn that
+// each exclude one assignment of the other parity. The clauses stay in the DB,
+// and the constraints are eliminated into 'gauss', which propagates them
+// together in BCP(). Its reasons are sums of constraints, which are not RUP, so
+// there are none with -proof.
+void Solver::extract_xors()
+{
+	Assert(dl == 0);
+	if (proof_tracer)
+	{
+		if (verbose >= 1)
+			cout << "xor: not with -proof" << endl;
+		return;
+	}
+	// The clauses over each set of variables, as their sign masks: bit i is set if
+	// the i-th smallest variable is negated, i.e. is true in the excluded assignment
+	map<vector<Var>, vector<unsigned>> masks_of;
+	vector<Var> key;
+	for (int idx : cnf)
+	{
+		Clause &c = cnf[idx];
+		if (static_cast<int>(c.size()) > xor_size)
+			continue;
+		clause_t lits(c.begin(), c.end());
+		sort(lits.begin(), lits.end()); // by variable
+		key.clear();
+		unsigned mask = 0;
+		for (Lit l : lits)
+		{
+			if (!key.empty() && key.back() == l2v(l))
+				break; // a tautology
+			if (Neg(l))
+				mask |= 1u << key.size();
+			key.push_back(l2v(l));
+		}
+		if (key.size() == lits.size())
+			masks_of[key].push_back(mask);
+	}
+	vector<int> num_of_size(xor_size + 1);
+	int num_xors = 0;
+	for (auto &[vars, masks] : masks_of)
+	{
+		const size_t needed = size_t(1) << (vars.size() - 1);
+		sort(masks.begin(), masks.end());
+		masks.erase(unique(masks.begin(), masks.end()), masks.end());
+		if (masks.size() < needed)
+			continue;
+		size_t num_of_parity[2] = {0, 0};
+		for (unsigned m : masks)
+			++num_of_parity[__builtin_popcount(m) & 1];
+		for (int parity = 0; parity < 2; ++parity)
+			if (num_of_parity[parity] == needed)
+			{ // all assignments of this parity are excluded
+				gauss.add_xor(vars, !parity);
+				++num_of_size[vars.size()];
+				++num_xors;
+			}
+	}
+	if (!num_xors)
+		return;
+	// BCP() propagates them after the literals on the trail, so rows of one
+	// variable, which need none, are asserted here
+	xor_implied.clear();
+	if (!gauss.build(Gauss_max_bits) || !gauss.propagate(vals.data(), xor_implied, xor_conflict))
+	{
+		print_stats();
+		Abort("UNSAT (the XOR constraints contradict each other)", 0);
+	}
+	for (const clause_t &c : xor_implied)
+		assert_lit(c[0]);
+	if (verbose >= 1)
+	{
+		cout << "xor: " << num_xors << " constraints (";
+		for (int n = 2; n <= xor_size; ++n)
+			cout << (n > 2 ? ", " : "") << "size " << n << ": " << num_of_size[n];
+		if (gauss.empty())
+			cout << "), too many to propagate" << endl;
+		else
+			cout << "), matrix " << gauss.rows() << " x " << gauss.cols() << " (" << gauss.memory() / 1024 << " KB), " << row_xor_kernel() << " row operations" << endl;
+	}
+}
+
+// Forward subsumption and strengthening (self-subsuming resolution) of the
+// learnt clauses, at decision level 0 with BCP completed. Clauses are visited
+// from short to long, and every clause that is kept is watched by one of its
+// literals, so each clause is only compared with the shorter ones that share
+// a variable with it. Clauses that were compared with each other in the
+// previous call are not compared again. Units found on the way are asserted.
+// Returns UNSAT if they contradict each other.
+SolverState Solver::subsume()
+{
+	Assert(dl == 0 && conflicting_clause_idx < 0);
+	next_subsume = num_restarts + subsume_learnts;
+	const double begin_time = cpuTime();
+	vector<clause_t> learnts;
+	const int num_old = collect_clauses(learnts, first_learnt, cnf.top(), subsumed_top);
+
+	vector<int> order(learnts.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](int a, int b)
+				{ return learnts[a].size() < learnts[b].size(); });
+	vector<unsigned> sig(learnts.size());
+	vector<bool> removed(learnts.size());
+	vector<vector<int>> old_watch(nlits + 1), new_watch(nlits + 1);
+	vector<bool> lit_mark(nlits + 1);
+	clause_t units;
+	int num_subsumed = 0, num_strengthened = 0;
+	int64_t steps = 0, max_steps = 0;
+	for (const clause_t &c : learnts)
+		max_steps += Subsume_effort * c.size();
+
+	// Compares learnts[i], whose literals are marked, with the clauses in 'list'.
+	// Returns true if one of them subsumes it. The literals that can be removed
+	// by strengthening are unmarked on the way, and the rest of the comparisons
+	// are with the strengthened clause.
+	auto compare = [&](const vector<int> &list, int i)
+	{
+		const clause_t &d = learnts[i];
+		for (int j : list)
+		{
+			const clause_t &c = learnts[j];
+			++steps;
+			if (removed[j] || c.size() > d.size() || (sig[j] & ~sig[i]))
+				continue;
+			steps += c.size();
+			Lit neg = 0;
+			bool contained = true;
+			for (Lit x : c)
+			{
+				if (lit_mark[x])
+					continue;
+				if (!neg && lit_mark[::negate(x)])
+				{
+					neg = ::negate(x);
+					continue;
+				}
+				contained = false;
+				break;
+			}
+			if (!contained)
+				continue;
+			if (!neg)
+				return true;
+			lit_mark[neg] = false;
+		}
+		return false;
+	};
+
+	for (int i : order)
+	{
+		if (steps > max_steps)
+			break; // the rest are kept as they are
+		clause_t &d = learnts[i];
+		sig[i] = 0;
+		for (Lit l : d)
+		{
+			lit_mark[l] = true;
+			sig[i] |= 1u << (l2v(l) & 31);
+		}
+		bool subsumed = false;
+		for (size_t k = 0; k < d.size() && !subsumed; ++k)
+			for (Lit w : {d[k], ::negate(d[k])})
+				if (lit_mark[d[k]] && (compare(new_watch[w], i) || (i >= num_old && compare(old_watch[w], i))))
+				{
+					subsumed = true;
+					break;
+				}
+		clause_t e;
+		for (Lit l : d)
+		{
+			if (lit_mark[l])
+				e.push_back(l);
+			lit_mark[l] = false;
+		}
+
+		if (subsumed)
+		{
+			if (proof_tracer)
+				proof_tracer->notify_deleted_clause(real_lits(d));
+			removed[i] = true;
+			++num_subsumed;
+			continue;
+		}
+		if (e.size() < d.size())
+		{
+			// A resolvent of d with the clauses that strengthened it, so it is RUP
+			if (proof_tracer)
+			{
+				proof_tracer->notify_added_clause(real_lits(e), false);
+				proof_tracer->notify_deleted_clause(real_lits(d));
+			}
+			d.swap(e);
+			++num_strengthened;
+		}
+		if (d.size() == 1)
+		{
+			units.push_back(d[0]);
+			removed[i] = true;
+			continue;
+		}
+		vector<vector<int>> &one_watch = i < num_old ? old_watch : new_watch;
+		Lit best = d[0];
+		for (Lit l : d)
+			if (one_watch[l].size() < one_watch[best].size())
+				best = l;
+		one_watch[best].push_back(i);
+	}
+
+	vector<clause_t> kept;
+	for (size_t i = 0; i < learnts.size(); ++i)
+		if (!removed[i])
+			kept.push_back(learnts[i]);
+	cnf.truncate(first_learnt);
+	attach_learnts(kept);
+	subsumed_top = cnf.top();
+	if (verbose >= 1)
+		cout << "subsumption: " << num_subsumed << " learnt clauses subsumed, " << num_strengthened << " strengthened, " << units.size() << " units in " << cpuTime() - begin_time << " s" << endl;
+
+	for (Lit l : units)
+	{
+		switch (lit_state(l))
+		{
+		case LitState::L_SAT:
+			break;
+		case LitState::L_UNSAT:
+			return SolverState::UNSAT;
+		default:
+			unaries.push_back(l); // already in the proof
+			assert_lit(l);
+		}
+	}
+	return SolverState::UNDEF;
+}
+
+void configure_reencoder(BVA::AutomatedReencoder &reencoder)
+{
+	reencoder.setIterations(bva_length);
+	reencoder.setTieBreaking((BVA::TieBreaking)bva_tiebreak);
+	reencoder.setEffort(bva_effort);
+	reencoder.setMinRate(bva_min_rate);
+	reencoder.setEliminationLimit(bve_occ_limit);
+}
+
+void Solver::solve()
+{
+	SolverState res = _solve();
+	stop_walker();
+	Assert(res == SolverState::SAT || res == SolverState::UNSAT || res == SolverState::TIMEOUT);
+	print_stats();
+	if (verbose >= 1)
+		cout << "[   EDUSAT   ] Memory ~ " << cnf.memory() / 1024 << " KB clauses, " << watches.memory() / 1024
+			 << " KB watch lists (" << watches.used_memory() / 1024 << " KB in use)" << endl;
+	switch (res)
+	{
+	case SolverState::SAT:
+	{
+		validate_assignment();
+		string str = "solution in ",
+			   str1 = Assignment_file;
+		cout << str + str1 << endl;
+		cout << "SAT" << endl;
+		break;
+	}
+	case SolverState::UNSAT:
+		cout << "UNSAT" << endl;
+		break;
+	case SolverState::TIMEOUT:
+		cout << "TIMEOUT" << endl;
+		return;
+	default:
+		return;
+	}
+	return;
+}
+
+// Equivalent literal substitution (ELS). The strongly connected components of
+// the binary implication graph are equivalence classes of literals, found with
+// Tarjan's algorithm. Every literal is replaced by the representative of its
+// class (the one with the smallest variable) in 'originals' and 'learnts', and
+// the replaced variables are put on the extension stack. Units are moved to
+// 'units'. Returns false if a literal is equivalent to its negation.
+bool Solver::substitute_equivalences(vector<clause_t> &originals, vector<clause_t> &learnts, clause_t &units, int &num_substituted)
+{
+	vector<vector<Lit>> implied(nlits + 1);
+	for (vector<clause_t> *clauses : {&originals, &learnts})
+		for (const clause_t &c : *clauses)
+			if (c.size() == 2)
+			{
+				implied[::negate(c[0])].push_back(c[1]);
+				implied[::negate(c[1])].push_back(c[0]);
+			}
+
+	vector<Lit> repr(nlits + 1, 0);
+	vector<int> index(nlits + 1, -1), low(nlits + 1);
+	vector<bool> on_stack(nlits + 1);
+	vector<Lit> stack;
+	vector<pair<Lit, size_t>> path; // the DFS path with the next edge to follow
+	int counter = 0;
+	num_substituted = 0;
+	for (Lit root = 1; root <= static_cast<Lit>(nlits); ++root)
+	{
+		if (index[root] >= 0 || implied[root].empty())
+			continue;
+		auto visit = [&](Lit l)
+		{
+			index[l] = low[l] = counter++;
+			stack.push_back(l);
+			on_stack[l] = true;
+			path.push_back({l, 0});
+		};
+		visit(root);
+		while (!path.empty())
+		{
+			const Lit l = path.back().first;
+			if (path.back().second < implied[l].size())
+			{
+				const Lit next = implied[l][path.back().second++];
+				if (index[next] < 0)
+					visit(next);
+				else if (on_stack[next])
+					low[l] = min(low[l], index[next]);
+				continue;
+			}
+			path.pop_back();
+			if (!path.empty())
+				low[path.back().first] = min(low[path.back().first], low[l]);
+			if (low[l] != index[l])
+				continue;
+			// l is the root of a component, which is on the stack above it: search from the top
+			auto first = find(stack.rbegin(), stack.rend(), l).base() - 1;
+			Lit best = l;
+			for (auto it = first; it != stack.end(); ++it)
+				if (l2v(*it) < l2v(best))
+					best = *it;
+			for (auto it = first; it != stack.end(); ++it)
+			{
+				on_stack[*it] = false;
+				repr[*it] = best;
+				if (repr[::negate(*it)] == best)
+				{ // best implies its negation, so it is false
+					if (proof_tracer)
+						proof_tracer->notify_added_clause({l2rl(::negate(best))}, false);
+					return false;
+				}
+			}
+			stack.erase(first, stack.end());
+		}
+	}
+
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+	{
+		const Lit l = v2l(v);
+		if (!repr[l] || repr[l] == l)
+			continue;
+		// v = repr, as two clauses that the witness v (or -v) satisfies
+		const int r = l2rl(repr[l]);
+		extension.insert(extension.end(), {0, -r, v, v, 0, r, -v, -v});
+		++num_substituted;
+	}
+	if (!num_substituted)
+		return true;
+
+	// The substituted clauses are RUP as long as the binary clauses of the
+	// components are there, so the old clauses are deleted only at the end.
+	vector<clause_t> deleted;
+	vector<signed char> lit_mark(nvars + 1);
+	for (vector<clause_t> *clauses : {&originals, &learnts})
+	{
+		size_t kept = 0;
+		for (clause_t &c : *clauses)
+		{
+			clause_t d;
+			bool tautology = false, changed = false;
+			for (Lit l : c)
+			{
+				const Lit r = repr[l] ? repr[l] : l;
+				changed |= r != l;
+				const signed char sign = Neg(r) ? -1 : 1;
+				if (lit_mark[l2v(r)] == sign)
+					continue;
+				if (lit_mark[l2v(r)] == -sign)
+				{
+					tautology = true;
+					break;
+				}
+				lit_mark[l2v(r)] = sign;
+				d.push_back(r);
+			}
+			for (Lit l : c)
+				lit_mark[l2v(repr[l] ? repr[l] : l)] = 0;
+			if (!changed)
+			{
+				(*clauses)[kept++].swap(c);
+				continue;
+			}
+			if (!tautology && proof_tracer)
+				proof_tracer->notify_added_clause(real_lits(d), false);
+			deleted.push_back(c);
+			if (tautology)
+				continue;
+			if (d.size() == 1)
+				units.push_back(d[0]);
+			else
+				(*clauses)[kept++].swap(d);
+		}
+		clauses->resize(kept);
+	}
+	if (proof_tracer)
+		for (const clause_t &c : deleted)
+			proof_tracer->notify_deleted_clause(real_lits(c));
+	return true;
+}
+
+// Failed literal probing. Every root of the binary implication graph (a literal
+// that no binary clause implies, so probing it covers everything it implies) is
+// assigned at decision level 1 and propagated. If that leads to a conflict, its
+// negation is a unit. Stops after Probe_effort propagations per clause.
+SolverState Solver::probe_failed_literals(int &num_failed)
+{
+	vector<bool> in_binary(nlits + 1);
+	for (int idx : cnf)
+	{
+		Clause &c = cnf[idx];
+		if (c.size() == 2)
+			in_binary[c.lit(0)] = in_binary[c.lit(1)] = true;
+	}
+	const vector<VarState> saved_phases = phases(); // probing is not a decision
+	const int64_t max_steps = static_cast<int64_t>(Probe_effort) * cnf.size();
+	int64_t steps = 0;
+	num_failed = 0;
+	Lit l = probe_start;
+	for (unsigned int i = 0; i < nlits && steps <= max_steps; ++i)
+	{
+		l = l % nlits + 1;
+		if (in_binary[l] || !in_binary[::negate(l)] || value(l2v(l)) != VarState::V_UNASSIGNED)
+			continue;
+		const size_t level_0 = trail.size();
+		dl = 1;
+		assert_lit(l);
+		vars[l2v(l)].reason = -1;
+		const SolverState res = BCP();
+		steps += trail.size() - level_0;
+		for (size_t j = level_0; j < trail.size(); ++j)
+		{
+			unassign(l2v(trail[j]));
+			unassigned(l2v(trail[j]));
+		}
+		trail.resize(level_0);
+		qhead = level_0;
+		dl = 0;
+		if (res != SolverState::CONFLICT)
+			continue;
+		conflicting_clause_idx = -1;
+		++num_failed;
+		const Lit unit = ::negate(l);
+		if (proof_tracer)
+			proof_tracer->notify_added_clause({l2rl(unit)}, false);
+		unit_logged[l2v(unit)] = true;
+		unaries.push_back(unit);
+		assert_lit(unit);
+		if (BCP() == SolverState::UNSAT)
+			return SolverState::UNSAT;
+	}
+	probe_start = l; // the next call resumes after it
+	set_phases(saved_phases);
+	return SolverState::UNDEF;
+}
+
+// Probing and equivalent literal substitution at decision level 0, before
+// the search and then every 'probe' restarts.
+SolverState Solver::probe()
+{
+	Assert(dl == 0 && conflicting_clause_idx < 0);
+	TIME_BLOCK("[   EDUSAT   ] Probing");
+	next_probe = num_restarts + probe_interval;
+	const double begin_time = cpuTime();
+
+	vector<clause_t> originals, learnts;
+	clause_t units;
+	collect_clauses(originals, 0, first_learnt);
+	collect_clauses(learnts, first_learnt, cnf.top());
+	int num_substituted = 0; // not with cardinality or XOR constraints, which would need it as well
+	if (cards.empty() && gauss.empty() && !substitute_equivalences(originals, learnts, units, num_substituted))
+		return SolverState::UNSAT;
+	cnf.truncate(0);
+	for (clause_t &c : originals)
+		cnf.add(c, 0, 1);
+	attach_learnts(learnts);
+	subsumed_top = first_learnt; // the learnt clauses moved
+
+	for (Lit l : units)
+	{
+		switch (lit_state(l))
+		{
+		case LitState::L_SAT:
+			break;
+		case LitState::L_UNSAT:
+			return SolverState::UNSAT;
+		default:
+			unaries.push_back(l); // already in the proof
+			assert_lit(l);
+		}
+	}
+	if (BCP() == SolverState::UNSAT)
+		return SolverState::UNSAT;
+
+	int num_failed;
+	if (probe_failed_literals(num_failed) == SolverState::UNSAT)
+		return SolverState::UNSAT;
+	if (VarDecHeuristic == VAR_DEC_HEURISTIC::MINISAT)
+	{
+		m_curr_activity = 0;
+		m_should_reset_iterators = true;
+	}
+	if (verbose >= 1)
+		cout << "probing: " << num_substituted << " equivalent variables substituted, " << num_failed << " failed literals in " << cpuTime() - begin_time << " s" << endl;
+	return SolverState::UNDEF;
+}
+// Copies the irredundant clauses into 'ls', without the ones satisfied at level 0
+// and without the literals false at level 0. The phases of the variables
+// assigned at level 0 are set to their values.
+void Solver::fill_local_search(LocalSearch &ls, vector<VarState> &phases)
+{
+	auto fixed = [&](Lit l) { return vars[l2v(l)].level == 0 && value(l2v(l)) != VarState::V_UNASSIGNED; };
+	clause_t lits;
+	for (int idx : cnf)
+	{
+		if (idx >= first_learnt)
+			break;
+		Clause &c = cnf[idx];
+		lits.clear();
+		bool sat = false;
+		for (Lit *it = c.begin(); it != c.end() && !sat; ++it)
+		{
+			if (!fixed(*it))
+				lits.push_back(*it);
+			else
+				sat = lit_state(*it) == LitState::L_SAT;
+		}
+		if (!sat)
+			ls.add_clause(lits);
+	}
+	// cardinality constraints as their clauses, over the literals that are not fixed
+	for (const Card &c : cards)
+	{
+		lits.clear();
+		int bound = c.bound;
+		for (Lit l : c.lits)
+			if (!fixed(l))
+				lits.push_back(::negate(l));
+			else if (lit_state(l) == LitState::L_SAT)
+				--bound;
+		if (static_cast<int>(lits.size()) > bound)
+			for_each_subset(lits, bound + 1, [&](const clause_t &d) { ls.add_clause(d); });
+	}
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		if (fixed(v2l(v)))
+			phases[v] = value(v);
+}
+
+// Local search from the saved phases. The best assignment found becomes the
+// saved phases, or the solution if it satisfies all clauses.
+SolverState Solver::walk()
+{
+	TIME_BLOCK("[   EDUSAT   ] Local search");
+	const double begin_time = cpuTime();
+	LocalSearch ls(nvars, num_walks++);
+	vector<VarState> walk_phases = phases();
+	fill_local_search(ls, walk_phases);
+	const int num_unsat = ls.run(walk_phases, static_cast<int64_t>(walk_effort) * ls.num_clauses());
+	if (verbose >= 1)
+		cout << "walk #" << num_walks << ": " << num_unsat << " unsatisfied clauses after " << ls.flips() << " flips in " << cpuTime() - begin_time << " s" << endl;
+	if (num_unsat == 0 && adopt_model(walk_phases))
+		return SolverState::SAT;
+	set_phases(walk_phases);
+	return SolverState::UNDEF;
+}
+
+// Starts local search on another thread, on a copy of the current clauses. It
+// runs until it finds a model or stop_walker() is called.
+void Solver::start_walker()
+{
+	walker_search.reset(new LocalSearch(nvars, UINT64_MAX));
+	walker_model = phases();
+	fill_local_search(*walker_search, walker_model);
+	walker = thread([this]
+	{
+		if (walker_search->run(walker_model, INT64_MAX, &walker_stop) == 0)
+			walker_found.store(true, memory_order_release);
+	});
+}
+
+void Solver::stop_walker()
+{
+	walker_stop = true;
+	if (walker.joinable())
+		walker.join();
+}
+
+// Takes 'model' as the solution if it satisfies all clauses, which may have
+// changed since it was found. Variables added since then are set to false.
+bool Solver::adopt_model(const vector<VarState> &model)
+{
+	auto model_value = [&](Var v) { return v < static_cast<Var>(model.size()) ? model[v] : VarState::V_FALSE; };
+	auto sat = [&](Lit l) { return ::lit_state(l, model_value(l2v(l))) == LitState::L_SAT; };
+	for (int idx : cnf)
+		if (none_of(cnf[idx].begin(), cnf[idx].end(), sat))
+			return false;
+	if (!all_of(unaries.begin(), unaries.end(), sat))
+		return false;
+	for (const Card &c : cards)
+		if (count_if(c.lits.begin(), c.lits.end(), sat) > c.bound)
+			return false;
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+	{
+		vals[v2l(v)] = model_value(v) == VarState::V_TRUE ? 1 : -1;
+		vals[v2l(-v)] = -vals[v2l(v)];
+	}
+	print_state(Assignment_file);
+	return true;
+}
+
+// The search loop, for the settings in P
+template <class P>
+SolverState Solver::search()
+{
+	SolverState res;
+	while (true)
 	{
 		if (timeout > 0 && cpuTime() - solving_begin_time > timeout)
 			return SolverState::TIMEOUT;
+		if (walker_found.load(memory_order_acquire))
+		{
+			walker_found = false;
+			stop_walker();
+			if (verbose >= 1)
+				cout << "walker found a model after " << walker_search->flips() << " flips" << endl;
+			if (adopt_model(walker_model))
+				return SolverState::SAT;
+			for (Var v = 1; v < static_cast<Var>(walker_model.size()); ++v)
+				vars[v].phase = walker_model[v]; // a model of the clauses before inprocessing
+		}
 		while (true)
 		{
-			res = BCP();
+			res = BCP<P>();
 			if (res == SolverState::UNSAT)
 			{
-				if (proof_tracer)
+				if (P::proof() && proof_tracer)
 					proof_tracer->notify_added_clause({}, false);
 				return res;
 			}
 			if (res == SolverState::CONFLICT)
-				backtrack(analyze(cnf[conflicting_clause_idx]));
+				backtrack<P>(analyze<P>(conflicting_clause_idx));
 			else
 				break;
 		}
-		res = decide();
+#ifndef NDEBUG
+		if (check_interval && num_learned >= next_check)
+		{
+			check_invariants();
+			next_check = num_learned + check_interval;
+		}
+#endif
+		if (rephase_interval && num_learned >= next_rephase && rephase() == SolverState::SAT)
+			return SolverState::SAT;
+		if (stable_mode == 1 && num_learned >= next_mode_switch)
+			switch_mode();
+		if (probe_interval && dl == 0 && num_restarts >= next_probe)
+		{
+			if (probe() == SolverState::UNSAT)
+			{
+				if (P::proof() && proof_tracer)
+					proof_tracer->notify_added_clause({}, false);
+				return SolverState::UNSAT;
+			}
+			if (qhead < trail.size())
+				continue;
+		}
+		if (!local_search_started && dl == 0)
+		{
+			local_search_started = true;
+			if (walk_thread)
+				start_walker();
+			if (walk_effort && walk() == SolverState::SAT)
+				return SolverState::SAT;
+		}
+		if (gc_waste > 0 && dl == 0 && num_assignments >= next_remove)
+			remove_satisfied();
+		if (bva_inprocess && dl == 0 && num_restarts >= next_inprocess)
+			inprocess();
+		if (subsume_learnts && dl == 0 && num_restarts >= next_subsume)
+		{
+			if (subsume() == SolverState::UNSAT)
+			{
+				if (P::proof() && proof_tracer)
+					proof_tracer->notify_added_clause({}, false);
+				return SolverState::UNSAT;
+			}
+			if (qhead < trail.size())
+				continue; // the new units are propagated first
+		}
+		res = decide<P>();
 		if (res == SolverState::SAT)
 			return res;
 	}
 }
 
-#pragma endregion solving
\ No newline at end of file
+#pragma endregion solving
+
+template <VAR_DEC_HEURISTIC VarDH, VAL_DEC_HEURISTIC ValDH>
+SolverState Solver::search_with(bool proof, bool verbose)
+{
+	if (proof)
+		return verbose ? search<StaticPolicy<VarDH, ValDH, true, true>>() : search<StaticPolicy<VarDH, ValDH, true, false>>();
+	return verbose ? search<StaticPolicy<VarDH, ValDH, false, true>>() : search<StaticPolicy<VarDH, ValDH, false, false>>();
+}
+
+// Chooses the instantiation of search() for the command-line settings, once.
+SolverState Solver::_solve()
+{
+	const bool proof = proof_tracer != nullptr, verbose = verbose_now(),
+			   litscore = ValDecHeuristic == VAL_DEC_HEURISTIC::LITSCORE;
+	switch (VarDecHeuristic)
+	{
+	case VAR_DEC_HEURISTIC::MINISAT:
+		return litscore ? search_with<VAR_DEC_HEURISTIC::MINISAT, VAL_DEC_HEURISTIC::LITSCORE>(proof, verbose)
+						: search_with<VAR_DEC_HEURISTIC::MINISAT, VAL_DEC_HEURISTIC::PHASESAVING>(proof, verbose);
+	case VAR_DEC_HEURISTIC::VMTF:
+		return litscore ? search_with<VAR_DEC_HEURISTIC::VMTF, VAL_DEC_HEURISTIC::LITSCORE>(proof, verbose)
+						: search_with<VAR_DEC_HEURISTIC::VMTF, VAL_DEC_HEURISTIC::PHASESAVING>(proof, verbose);
+	case VAR_DEC_HEURISTIC::LRB:
+		return litscore ? search_with<VAR_DEC_HEURISTIC::LRB, VAL_DEC_HEURISTIC::LITSCORE>(proof, verbose)
+						: search_with<VAR_DEC_HEURISTIC::LRB, VAL_DEC_HEURISTIC::PHASESAVING>(proof, verbose);
+	default:
+		Assert(0);
+		return SolverState::UNDEF;
+	}
+}
@@ -3,20 +3,48 @@
 #include "clause.h"
 #include "bva.h"
 #include "proof.h"
+#include "heap.h"
+#include "walk.h"
+#include "watch_search.h"
+#include "policy.h"
+#include "watch_pool.h"
+#include "gauss.h"
+#include <thread>
+#include <memory>
+
+// The per-variable data that analyze() reads together, in one record.
+struct VarInfo {
+	int level = 0;		// decision level in which the variable was assigned its value
+	int reason = -1;	// clause index in the cnf of the clause that gave the variable its value in BCP, card_reason() or xor_reason(). -1 for decisions
+	VarState phase = VarState::V_FALSE; // for phase-saving: the last value, not reset upon backtracking. Initially false
+	bool seen = false;	// seen during analyze()
+};
 
 class Solver {
-	vector<Clause> cnf; // clause DB. 
+	ClauseDB cnf; // clause DB. 
 	vector<int> unaries; 
 	trail_t trail;  // assignment stack	
 	vector<int> separators; // indices into trail showing increase in dl 	
 	vector<int> LitScore; // literal => frequency of this literal (# appearances in all clauses). 
-	vector<vector<int> > watches;  // Lit => vector of clause indices into CNF
-	vector<VarState> state;  // current assignment
-	vector<VarState> prev_state; // for phase-saving: same as state, only that it is not reset to 0 upon backtracking. 
-	vector<int> antecedent; // var => clause index in the cnf vector. For variables that their value was assigned in BCP, this is the clause that gave this variable its value. 
-	vector<bool> marked;	// var => seen during analyze()
-	vector<int> dlevel; // var => decision level in which this variable was assigned its value. 
+	WatchPool watches;  // Lit => clause indices into CNF
+	vector<signed char> vals;  // current assignment. Lit => 1 if it is true, -1 if false, 0 if unassigned. Padded for find_not_false()
+	vector<VarInfo> vars;	// var => level, reason and phase
+	vector<bool> unit_logged; // var => its level-0 value was added to the proof by log_root_units()
 	vector<int> conflicts_at_dl; // decision level => # of conflicts under it. Used for local restarts.
+	vector<int> extension; // clauses eliminated in preprocessing. See BVA::AutomatedReencoder::exportExtension.
+	vector<VarState> target_phase; // var => value in the longest conflict-free trail since the last rephase. V_UNASSIGNED if none
+	vector<VarState> best_phase; // same, but not reset by restarts. Used by rephasing
+	int target_size, best_size; // # of literals on the trail of target_phase, best_phase
+	int first_learnt; // index into cnf of the first learnt clause. All clauses before it are irredundant.
+	int subsumed_top; // the learnt clauses below this index into cnf were already subsumed by each other
+	Lit probe_start; // probe_failed_literals() starts after this literal
+	vector<Card> cards; // at-most-k constraints that replace their clauses (see extract_cardinality())
+	vector<vector<int>> card_occs; // Lit => indices into cards of the constraints it is in. Empty if there are none
+	vector<int> explanation; // the last clause made by reason_clause() for a constraint, in the ClauseDB layout
+	GaussMatrix gauss; // XOR constraints recovered from the clauses (see extract_xors()). Empty if there are none
+	ClauseDB xor_reasons; // the reasons and conflicts found by gauss, until the next restart
+	vector<clause_t> xor_implied; // scratch for gauss_propagate()
+	clause_t xor_conflict;
 
 public:
 	ProofTracer *proof_tracer;
@@ -34,6 +62,33 @@ private:
 	double			m_curr_activity;
 	bool			m_should_reset_iterators;
 
+	// Used by VAR_DH_VMTF: all variables in a doubly linked queue, ordered by the
+	// time they were last bumped. decide() searches it backwards from vmtf_search,
+	// and every variable after vmtf_search is assigned.
+	vector<Var>		vmtf_prev, vmtf_next; // var => neighbours in the queue. 0 if none
+	vector<int64_t>	vmtf_stamp;	// var => time of its last bump (enqueue)
+	Var				vmtf_first, vmtf_last, vmtf_search;
+	int64_t			vmtf_stamps; // # of enqueues so far
+	vector<Var>		vmtf_bumped; // variables seen by analyze(), bumped at its end
+
+	// Used by VAR_DH_LRB: learning rate branching (Liang et al., SAT 2016). The score
+	// of a variable is an exponential moving average of the rate at which it took part
+	// in conflicts (participated) or in the reasons of the learnt clause (reasoned)
+	// while it was assigned, updated when it becomes unassigned.
+	vector<double>	lrb_q;	// var => score
+	vector<int>		lrb_assigned, lrb_participated, lrb_reasoned; // var => # of learnt clauses when assigned, counters since
+	vector<int>		lrb_canceled; // var => # of learnt clauses when last unassigned, for the locality decay
+	double			lrb_alpha; // step size of the moving average
+	VarHeap			lrb_heap; // unassigned variables by score. May contain assigned ones
+	vector<Var>		lrb_seen; // variables counted by lrb_reason_side()
+
+	// Used by -walk-thread: ProbSAT on a copy of the irredundant clauses, concurrently
+	// with the search. Once walker_found is set walker_model is a model of them.
+	thread			walker;
+	unique_ptr<LocalSearch> walker_search;
+	vector<VarState> walker_model;
+	atomic<bool>	walker_stop, walker_found;
+
 	unsigned int 
 		nvars,			// # vars
 		nclauses, 		// # clauses
@@ -46,12 +101,31 @@ private:
 		num_restarts,
 		dl,				// decision level
 		max_dl,			// max dl seen so far since the last restart
-		conflicting_clause_idx, // holds the index of the current conflicting clause in cnf[]. -1 if none.				
+		conflicting_clause_idx, // holds the index of the current conflicting clause in cnf[], or card_reason() or xor_reason(). -1 if none.				
 		restart_threshold,
 		restart_lower,
-		restart_upper;
+		restart_upper,
+		next_inprocess,	// # of restarts at which inprocess() runs next
+		inprocess_interval,
+		num_inprocessings,
+		next_subsume,	// # of restarts at which subsume() runs next
+		next_probe,		// # of restarts at which probe() runs next
+		next_remove,	// # of assignments at which remove_satisfied() runs next
+		root_assigned,	// # of level-0 variables when remove_satisfied() last ran
+		next_check,		// # of learnt clauses at which check_invariants() runs next
+		next_rephase,	// # of learnt clauses at which rephase() runs next
+		num_rephases,
+		num_walks,		// # of walk() runs
+		next_mode_switch, // # of learnt clauses at which the mode switches next
+		mode_length,	// # of learnt clauses of the next focused mode
+		restart_conflicts, // # of learnt clauses at the last restart
+		stable_restarts; // # of restarts in stable mode, the index into the Luby sequence
+
+	bool		stable;	// stable mode: fewer restarts, and decisions by the target phases
+	bool		local_search_started; // walk() and the walker ran (started) before the search
 
-	Lit 		asserted_lit;
+	Lit 		asserted_lit; // asserted by backtrack(), at level asserted_level, by asserted_antecedent
+	int			asserted_level, asserted_antecedent;
 
 	float restart_multiplier;
 	
@@ -61,7 +135,20 @@ private:
 	int get_nvars() { return nvars; }
 	void set_nclauses(int x) { nclauses = x; }
 	size_t cnf_size() { return cnf.size(); }
-	VarState get_state(int x) { return state[x]; }
+	VarState get_state(int x) { return value(x); }
+	VarState value(Var v) const { return vals[v2l(v)] > 0 ? VarState::V_TRUE : vals[v2l(v)] < 0 ? VarState::V_FALSE : VarState::V_UNASSIGNED; }
+	LitState lit_state(Lit l) const { return vals[l] > 0 ? LitState::L_SAT : vals[l] < 0 ? LitState::L_UNSAT : LitState::L_UNASSIGNED; }
+	void unassign(Var v) { vals[v2l(v)] = vals[v2l(-v)] = 0; }
+	vector<VarState> phases() const { // var => saved phase
+		vector<VarState> res(nvars + 1, VarState::V_FALSE);
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			res[v] = vars[v].phase;
+		return res;
+	}
+	void set_phases(const vector<VarState> &phases) {
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			vars[v].phase = phases[v];
+	}
 
 	// misc.
 	void add_to_trail(int x) { trail.push_back(x); }
@@ -70,50 +157,105 @@ private:
 	void initialize();
 	void reset_iterators(double activity_key = 0.0);	
 
-	// solving	
-	SolverState decide();
-	void test();
-	SolverState BCP();
-	int  analyze(const Clause);
-	inline int  getVal(Var v);
-	inline void add_clause(Clause& c, int l, int r, bool original = false);
-	inline void add_unary_clause(Lit l, bool original = false);
-	inline void assert_lit(Lit l);	
+	// solving. The hot functions are templates on a policy (see policy.h).
+	template <class P> SolverState search();
+	template <VAR_DEC_HEURISTIC VarDH, VAL_DEC_HEURISTIC ValDH> SolverState search_with(bool proof, bool verbose);
+	template <class P = DynamicPolicy> SolverState decide();
+	void check_invariants();
+	template <class P = DynamicPolicy> SolverState BCP();
+	template <class P = DynamicPolicy> void gauss_propagate();
+	template <class P = DynamicPolicy> int analyze(int conflicting_idx);
+	template <class P = DynamicPolicy> int getVal(Var v);
+	template <class P = DynamicPolicy> void add_clause(clause_t& c, int l, int r, bool original = false);
+	template <class P = DynamicPolicy> void add_unary_clause(Lit l, bool original = false);
+	template <class P = DynamicPolicy> void assert_lit(Lit l);
 	void m_rescaleScores(double& new_score);
-	inline void backtrack(int k);
-	void restart();
+	template <class P = DynamicPolicy> void backtrack(int k);
+	template <class P = DynamicPolicy> void unassign_above(int k);
+	int max_level(Clause &c, Lit except = 0);
+	// The reason or conflict index of cards[c] and of xor_reasons[i], and back
+	static int card_reason(int c) { return -2 - 2 * c; }
+	static int xor_reason(int i) { return -3 - 2 * i; }
+	static bool is_xor_reason(int idx) { return idx < -1 && (idx & 1); }
+	static int card_of(int idx) { return (-2 - idx) / 2; }
+	static int xor_of(int idx) { return (-3 - idx) / 2; }
+	Clause &reason_clause(int idx, Lit implied = 0);
+	template <class P = DynamicPolicy> void restart();
+	bool restart_due(int k);
+	void update_target_and_best();
+	SolverState rephase();
+	void switch_mode();
+	bool satisfied(Clause &c);
+	void log_root_units();
+	size_t collect_clauses(vector<clause_t> &res, int begin, int end, int top = 0);
+	void attach_learnts(vector<clause_t> &learnts);
+	void remove_satisfied();
+	void collect_garbage();
+	void extract_cardinality();
+	void extract_xors();
+	void inprocess();
+	SolverState subsume();
+	bool substitute_equivalences(vector<clause_t> &originals, vector<clause_t> &learnts, clause_t &units, int &num_substituted);
+	SolverState probe_failed_literals(int &num_failed);
+	SolverState probe();
+	void fill_local_search(LocalSearch &ls, vector<VarState> &phases);
+	SolverState walk();
+	void start_walker();
+	void stop_walker();
+	bool adopt_model(const vector<VarState> &model);
+	void grow_vars(unsigned int new_nvars);
 	
 	// scores	
 	inline void bumpVarScore(int idx);
 	inline void bumpLitScore(int lit_idx);
+	void vmtf_enqueue(Var v);
+	void vmtf_dequeue(Var v);
+	void vmtf_bump_analyzed();
+	void grow_lrb(unsigned int old_nvars);
+	void lrb_unassigned(Var v);
+	void lrb_reason_side(const clause_t &learnt);
+	// keeps the invariant of vmtf_search when v becomes unassigned
+	void vmtf_unassigned(Var v) { if (vmtf_stamp[v] > vmtf_stamp[vmtf_search]) vmtf_search = v; }
+	// bookkeeping of the decision heuristic when v becomes unassigned
+	template <class P = DynamicPolicy> void unassigned(Var v) {
+		if (P::var_dh() == VAR_DEC_HEURISTIC::VMTF)
+			vmtf_unassigned(v);
+		else if (P::var_dh() == VAR_DEC_HEURISTIC::LRB)
+			lrb_unassigned(v);
+	}
 
 public:
 	Solver():
-		proof_tracer(0),
-		nvars(0), nclauses(0), num_learned(0), num_decisions(0), num_assignments(0), 
-		num_restarts(0), m_var_inc(1.0), qhead(0), 
+		target_size(0), best_size(0), first_learnt(0), subsumed_top(0), probe_start(0), 
+		proof_tracer(0), m_var_inc(1.0), vmtf_first(0), vmtf_last(0), vmtf_search(0), 
+		vmtf_stamps(0), lrb_alpha(Lrb_alpha_start), lrb_heap(lrb_q), 
+		walker_stop(false), walker_found(false), nvars(0), nclauses(0), qhead(0), 
+		num_learned(0), num_decisions(0), num_assignments(0), num_restarts(0), 
 		restart_threshold(Restart_lower), restart_lower(Restart_lower), 
-		restart_upper(Restart_upper), restart_multiplier(Restart_multiplier) {};
-	~Solver() { delete proof_tracer; }
+		restart_upper(Restart_upper), num_inprocessings(0), num_walks(0), 
+		local_search_started(false), restart_multiplier(Restart_multiplier) {};
+	~Solver() { stop_walker(); delete proof_tracer; }
 	void read_cnf(ifstream& in);
-	void read_cnf(const unordered_set<BVA::Clause *, BVA::ClauseHasher> &cnf, const int max_var);
-	VarState get_lit_state(int l) { return state[l2v(l)]; }
+	void read_cnf(vector<int> &clauses, const vector<Lit> &units, const int max_var);
+	void set_extension(vector<int> &e) { extension.swap(e); }
+	void extend_model(vector<VarState> &model);
+	VarState get_lit_state(int l) { return value(l2v(l)); }
 	SolverState _solve();
 	void solve();
 
-	ClauseState next_not_false(Clause &c, bool is_left_watch, Lit other_watch, bool binary, int& loc);
+	template <class P = DynamicPolicy> ClauseState next_not_false(Clause &c, bool is_left_watch, Lit other_watch, bool binary, int& loc);
 	
 	// debugging
 	void print_cnf(){
-		for(vector<Clause>::iterator i = cnf.begin(); i != cnf.end(); ++i) {
-			i -> print_with_watches(); 
+		for (int idx : cnf) {
+			cnf[idx].print_with_watches(); 
 			cout << endl;
 		}
 	} 
 
 	void print_real_cnf() {
-		for(vector<Clause>::iterator i = cnf.begin(); i != cnf.end(); ++i) {
-			i -> print_real_lits(); 
+		for (int idx : cnf) {
+			cnf[idx].print_real_lits(); 
 			cout << endl;
 		}
 	} 
@@ -121,24 +263,28 @@ public:
 	void print_state(const char *file_name) {
 		ofstream out;
 		out.open(file_name);		
-		for (vector<VarState>::iterator it = state.begin() + 1; it != state.end(); ++it) {
+		vector<VarState> model(nvars + 1);
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+			model[v] = value(v);
+		extend_model(model);
+		for (vector<VarState>::iterator it = model.begin() + 1; it != model.end(); ++it) {
 			char sign = (*it) == VarState::V_FALSE ? -1 : (*it) == VarState::V_TRUE ? 1 : 0;
-			out << sign * (it - state.begin()) << " "; out << endl;
+			out << sign * (it - model.begin()) << " "; out << endl;
 		}
 	}	
 
 	void print_state() {
-		for (vector<VarState>::iterator it = state.begin() + 1; it != state.end(); ++it) {
-			char sign = (*it) == VarState::V_FALSE ? -1 : (*it) == VarState::V_TRUE ? 1 : 0;
-			cout << sign * (it - state.begin()) << " "; cout << endl;
+		for (Var v = 1; v <= static_cast<Var>(nvars); ++v) {
+			char sign = vals[v2l(v)];
+			cout << sign * v << " "; cout << endl;
 		}
 	}	
 	
 	void print_watches() {
-		for (vector<vector<int> >::iterator it = watches.begin() + 1; it != watches.end(); ++it) {
-			cout << distance(watches.begin(), it) << ": ";
-			for (vector<int>::iterator it_c = (*it).begin(); it_c != (*it).end(); ++it_c) {
-				cnf[*it_c].print();
+		for (Lit l = 1; l < static_cast<Lit>(watches.num_lists()); ++l) {
+			cout << l << ": ";
+			for (int idx : watches[l]) {
+				cnf[idx].print();
 				cout << "; ";
 			}
 			cout << endl;
@@ -157,4 +303,7 @@ public:
 	void validate_assignment();
 };
 
+// Applies the BVA command-line options to a reencoder.
+void configure_reencoder(BVA::AutomatedReencoder &);
+
 
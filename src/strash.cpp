@@ -0,0 +1,442 @@
+#include "bva.h"
+#include <map>
+#include <tuple>
+
+// Structural hashing (strash) of circuit-derived formulas, as in AIG packages.
+// AND, XOR and ITE gates are recovered from their Tseitin clauses, and gates
+// of the same type over equivalent inputs are merged: their outputs are
+// equivalent. The equivalences are added as binary clauses, then every merged
+// variable is replaced by its representative, which leaves the clauses of the
+// merged gates as duplicates. Last, the gates whose output is used by no other
+// clause are removed (cone of influence reduction).
+
+namespace BVA
+{
+    // XOR: o = x ^ y, the four ternary clauses over o, x, y that exclude the
+    // assignments of one parity. 'v' is the variable of o.
+    bool AutomatedReencoder::findXorGate(int v, Gate &g)
+    {
+        // The ternary clauses of v as the other two variables, then the signs of
+        // all three literals (bit 0: v)
+        vector<tuple<int, int, unsigned, Clause *>> ternary;
+        for (int lit : {v, -v})
+            for (Clause *c : occs(lit))
+            {
+                stats.strash_steps++;
+                if (c->size() != 3)
+                    continue;
+                int x = 0, y = 0;
+                for (int other : *c)
+                    if (other != lit)
+                        (x ? y : x) = other;
+                if (vidx(x) == vidx(y) || vidx(x) == v || vidx(y) == v)
+                    continue;
+                if (vidx(x) > vidx(y))
+                    swap(x, y);
+                ternary.push_back({vidx(x), vidx(y), (lit < 0) | (x < 0) << 1 | (y < 0) << 2, c});
+            }
+        sort(ternary.begin(), ternary.end());
+        for (size_t i = 0, j; i < ternary.size(); i = j)
+        {
+            const int x = get<0>(ternary[i]), y = get<1>(ternary[i]);
+            for (j = i; j < ternary.size() && get<0>(ternary[j]) == x && get<1>(ternary[j]) == y; ++j)
+                ;
+            for (unsigned parity : {0u, 1u})
+            {
+                gate.clear();
+                unsigned seen = 0;
+                for (size_t k = i; k < j; ++k)
+                {
+                    const unsigned mask = get<2>(ternary[k]);
+                    if ((__builtin_popcount(mask) & 1) != parity || (seen >> mask & 1))
+                        continue;
+                    seen |= 1u << mask;
+                    gate.push_back(get<3>(ternary[k]));
+                }
+                if (gate.size() == 4)
+                { // v ^ x ^ y is not 'parity', as a negative literal excludes its variable being true
+                    g = {GateType::XOR, parity ? v : -v, {x, y}};
+                    return true;
+                }
+            }
+        }
+        gate.clear();
+        return false;
+    }
+
+    // ITE: o = c ? t : e, the clauses (-o | -c | t), (o | -c | -t), (-o | c | e)
+    // and (o | c | -e). 'v' is the variable of o.
+    bool AutomatedReencoder::findIteGate(int v, Gate &g)
+    {
+        typedef tuple<int, int, Clause *> Pair;
+        auto find_pair = [](const vector<Pair> &pairs, int a, int b) -> Clause *
+        {
+            auto it = lower_bound(pairs.begin(), pairs.end(), Pair{a, b, nullptr});
+            return it != pairs.end() && get<0>(*it) == a && get<1>(*it) == b ? get<2>(*it) : nullptr;
+        };
+        for (int o : {v, -v})
+        {
+            // The ternary clauses of -o and of o as the pairs of their other literals, in both orders
+            vector<Pair> neg, pos;
+            for (auto [lit, pairs] : {pair<int, vector<Pair> *>{-o, &neg}, {o, &pos}})
+            {
+                for (Clause *c : occs(lit))
+                {
+                    stats.strash_steps++;
+                    if (c->size() != 3)
+                        continue;
+                    int a = 0, b = 0;
+                    for (int other : *c)
+                        if (other != lit)
+                            (a ? b : a) = other;
+                    if (vidx(a) == vidx(b) || vidx(a) == v || vidx(b) == v)
+                        continue;
+                    pairs->push_back({a, b, c});
+                    pairs->push_back({b, a, c});
+                }
+                sort(pairs->begin(), pairs->end());
+            }
+            for (const auto &[not_c, t, c1] : neg)
+            {
+                Clause *c2 = find_pair(pos, not_c, -t);
+                if (!c2)
+                    continue;
+                const int c = -not_c;
+                for (auto it = lower_bound(neg.begin(), neg.end(), Pair{c, INT_MIN, nullptr}); it != neg.end() && get<0>(*it) == c; ++it)
+                {
+                    stats.strash_steps++;
+                    const int e = get<1>(*it);
+                    if (vidx(e) == vidx(t)) // e = t is a buffer, e = -t an XOR
+                        continue;
+                    if (Clause *c4 = find_pair(pos, c, -e))
+                    {
+                        gate = {c1, c2, get<2>(*it), c4};
+                        g = {GateType::ITE, o, {c, t, e}};
+                        return true;
+                    }
+                }
+            }
+        }
+        gate.clear();
+        return false;
+    }
+
+    // The gate that defines 'v', if any, with its clauses in 'gate'
+    bool AutomatedReencoder::findAnyGate(int v, Gate &g)
+    {
+        gate.clear();
+        for (int lit : {v, -v})
+        {
+            if (!findGate(lit))
+                continue;
+            if (gate[0]->size() < 2)
+            { // a unit, not a definition
+                gate.clear();
+                continue;
+            }
+            g = {GateType::AND, lit, {}};
+            for (int other : *gate[0])
+                if (other != lit)
+                    g.inputs.push_back(-other);
+            return true;
+        }
+        return findXorGate(v, g) || findIteGate(v, g);
+    }
+
+    // The literal that 'lit' was merged into, through any number of merges.
+    // The path is compressed.
+    int AutomatedReencoder::representative(int lit)
+    {
+        auto next = [&](int l)
+        { return l < 0 ? -repr[vidx(l)] : repr[vidx(l)]; };
+        int res = lit;
+        while (repr[vidx(res)])
+            res = next(res);
+        for (int l = lit; repr[vidx(l)];)
+        {
+            const int n = next(l);
+            repr[vidx(l)] = l < 0 ? -res : res;
+            l = n;
+        }
+        return res;
+    }
+
+    // The type and inputs of 'g' in terms of the representatives, normalized so
+    // that equal keys are the same function: sorted AND inputs, positive XOR
+    // inputs and a positive ITE condition and then input. Returns the output
+    // literal, negated by the normalization if needed, or 0 if the gate is
+    // constant or simpler than its type.
+    int AutomatedReencoder::strashKey(const Gate &g, vector<int> &key)
+    {
+        key.assign(1, static_cast<int>(g.type));
+        int out = g.output;
+        switch (g.type)
+        {
+        case GateType::AND:
+            for (int in : g.inputs)
+                key.push_back(representative(in));
+            sort(key.begin() + 1, key.end());
+            key.erase(unique(key.begin() + 1, key.end()), key.end());
+            for (size_t i = 1; i < key.size(); ++i)
+                if (binary_search(key.begin() + 1, key.end(), -key[i]))
+                    return 0; // false
+            return out;
+        case GateType::XOR:
+            for (int in : g.inputs)
+            {
+                int r = representative(in);
+                if (r < 0)
+                    r = -r, out = -out;
+                key.push_back(r);
+            }
+            if (key[1] == key[2])
+                return 0;
+            if (key[1] > key[2])
+                swap(key[1], key[2]);
+            return out;
+        case GateType::ITE:
+        {
+            int c = representative(g.inputs[0]), t = representative(g.inputs[1]), e = representative(g.inputs[2]);
+            if (c < 0)
+                c = -c, swap(t, e);
+            if (t < 0)
+                t = -t, e = -e, out = -out;
+            if (vidx(c) == vidx(t) || vidx(c) == vidx(e) || vidx(t) == vidx(e))
+                return 0;
+            key.insert(key.end(), {c, t, e});
+            return out;
+        }
+        }
+        return 0;
+    }
+
+    // Adds a clause that the formula implies. Unless 'split' is 0, the clause is
+    // RUP only in each case of 'split', so the two cases are added to the proof
+    // before it and deleted after it.
+    void AutomatedReencoder::addDerived(const vector<int> &lits, int split)
+    {
+        Clause *c = arena.allocate(lits);
+        if (find(*c))
+        {
+            arena.release(c);
+            return;
+        }
+        if (proof)
+        {
+            for (int l : {split, -split})
+                if (split)
+                {
+                    resolvent = lits;
+                    resolvent.push_back(l);
+                    proof->notify_added_clause(resolvent, false /*learnt*/);
+                }
+            proof->notify_added_clause(lits, false /*learnt*/);
+            for (int l : {split, -split})
+                if (split)
+                {
+                    resolvent = lits;
+                    resolvent.push_back(l);
+                    proof->notify_deleted_clause(resolvent);
+                }
+        }
+        cnf.insert(c);
+        for (int lit : *c)
+            occs(lit).push_back(c);
+    }
+
+    // Adds o1 = o2, where o1 is the output of 'g' and o2 that of a gate with the
+    // same key, and merges their representatives. With the clauses of both
+    // gates and the equivalences added so far, o1 = o2 is RUP for AND gates,
+    // and for XOR and ITE gates once their first input is assigned. Returns
+    // false if they were merged already.
+    bool AutomatedReencoder::merge(const Gate &g, int o1, int o2)
+    {
+        const int r1 = representative(o1), r2 = representative(o2);
+        if (r1 == r2)
+            return false;
+        const int split = g.type == GateType::AND ? 0 : g.inputs[0];
+        addDerived(o1 == -o2 ? vector<int>{-o1} : vector<int>{-o1, o2}, split);
+        addDerived(o1 == -o2 ? vector<int>{o1} : vector<int>{o1, -o2}, split);
+        if (r1 == -r2)
+            return false; // the formula is unsatisfiable, which is left to the solver
+        if (vidx(r1) < vidx(r2))
+            repr[vidx(r2)] = r2 < 0 ? -r1 : r1;
+        else
+            repr[vidx(r1)] = r1 < 0 ? -r2 : r2;
+        stats.merged++;
+        return true;
+    }
+
+    // Replaces the merged variables by their representatives. The new clauses are
+    // RUP as long as the equivalences are there, so the old ones are deleted
+    // last. A merged variable is restored from its representative, as two
+    // clauses that it satisfies, on the extension stack.
+    void AutomatedReencoder::substituteMerged()
+    {
+        vector<Clause *> old;
+        for (Clause *c : cnf)
+            for (int lit : *c)
+                if (repr[vidx(lit)])
+                {
+                    old.push_back(c);
+                    break;
+                }
+        for (Clause *c : old)
+        {
+            resolvent.clear();
+            bool is_tautology = false;
+            for (int lit : *c)
+            {
+                const int r = representative(lit);
+                if (marked(r) > 0)
+                    continue;
+                if (marked(r) < 0)
+                {
+                    is_tautology = true;
+                    break;
+                }
+                mark(r);
+                resolvent.push_back(r);
+            }
+            for (int lit : resolvent)
+                unmark(lit);
+            if (is_tautology)
+                continue;
+            Clause *d = arena.allocate(resolvent);
+            if (find(*d))
+            { // the same clause of the representative's gate
+                arena.release(d);
+                continue;
+            }
+            if (proof)
+                proof->notify_added_clause(resolvent, false /*learnt*/);
+            cnf.insert(d);
+            for (int lit : *d)
+                occs(lit).push_back(d);
+        }
+        for (Clause *c : old)
+            disconnect(c);
+        for (int v = 1; v <= max_var; ++v)
+            if (repr[v])
+            {
+                const int r = representative(v);
+                extension.insert(extension.end(), {0, -r, v, v, 0, r, -v, -v});
+            }
+    }
+
+    // A gate whose output occurs in no other clause cannot affect the result.
+    // Its clauses are blocked on the output (all resolvents on it are
+    // tautologies), so they are removed and saved on the extension stack with
+    // the output as witness, like the ones of BVE. Then its inputs may become
+    // unused as well.
+    void AutomatedReencoder::removeUnusedGates()
+    {
+        vector<int> candidates;
+        for (int v = max_var; v >= 1; --v)
+            candidates.push_back(v);
+        Gate g;
+        while (!candidates.empty())
+        {
+            const int v = candidates.back();
+            candidates.pop_back();
+            if (repr[v] || !findAnyGate(v, g) || gate.size() != occs(v).size() + occs(-v).size())
+                continue;
+            for (Clause *c : gate)
+            {
+                extension.push_back(0);
+                extension.insert(extension.end(), c->begin(), c->end());
+                extension.push_back(*std::find_if(c->begin(), c->end(), [&](int lit)
+                                                  { return vidx(lit) == v; }));
+                for (int other : *c)
+                    if (vidx(other) != v)
+                        candidates.push_back(vidx(other));
+                disconnect(c);
+            }
+            stats.coi_removed++;
+        }
+    }
+
+    void AutomatedReencoder::applyStrash()
+    {
+        TIME_BLOCK("[PREPROCESSOR] Structural Hashing");
+        int64_t formula_size;
+        {
+            TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
+            formula_size = connectOccurrences();
+        }
+        repr.assign(max_var + 1, 0);
+
+        const int64_t max_steps = effort > 0 ? stats.strash_steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const char *limit_reached = nullptr;
+        vector<Gate> gates;
+        Gate g;
+        for (int v = 1; v <= max_var; ++v)
+        {
+            if (stats.strash_steps > max_steps)
+            {
+                limit_reached = "effort";
+                break;
+            }
+            if (!findAnyGate(v, g))
+                continue;
+            gates.push_back(g);
+            switch (g.type)
+            {
+            case GateType::AND:
+                stats.and_gates++;
+                break;
+            case GateType::XOR:
+                stats.xor_gates++;
+                break;
+            case GateType::ITE:
+                stats.ite_gates++;
+            }
+        }
+
+        // Every round of merges may make more keys equal, up to a fixpoint
+        map<vector<int>, int> output_of; // key => the output of the first gate with it
+        vector<int> key;
+        for (bool merged = true; merged && !limit_reached;)
+        {
+            merged = false;
+            output_of.clear();
+            for (const Gate &gt : gates)
+            {
+                stats.strash_steps += gt.inputs.size();
+                const int out = strashKey(gt, key);
+                if (!out)
+                    continue;
+                if (gt.type == GateType::AND && key.size() == 2)
+                { // all inputs are equivalent, and so is the output
+                    merged |= merge(gt, out, key[1]);
+                    continue;
+                }
+                auto [it, fresh] = output_of.emplace(key, out);
+                if (!fresh)
+                    merged |= merge(gt, out, it->second);
+            }
+            if (stats.strash_steps > max_steps)
+                limit_reached = "effort";
+        }
+        if (stats.merged)
+            substituteMerged();
+        removeUnusedGates();
+
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
+        else
+            cout << " -> Algorithm ended" << endl;
+
+        cout << "[PREPROCESSOR] Statistics:" << endl;
+        cout << "[PREPROCESSOR]    " << stats.and_gates << " AND, " << stats.xor_gates << " XOR and " << stats.ite_gates << " ITE gates" << endl;
+        cout << "[PREPROCESSOR]    " << stats.merged << " gates merged" << endl;
+        cout << "[PREPROCESSOR]    " << stats.coi_removed << " unused gates removed" << endl;
+        cout << "[PREPROCESSOR]    " << cnf.size() << " clauses remaining" << endl;
+
+        if (proof)
+        {
+            proof->notify_comment("    " + to_string(stats.merged) + " gates merged");
+            proof->notify_comment("    " + to_string(stats.coi_removed) + " unused gates removed");
+        }
+    }
+};
@@ -0,0 +1,160 @@
+#include "bva.h"
+
+// Backward subsumption and self-subsuming resolution (strengthening), as in
+// SatElite. Every clause C is checked against the clauses in the occurrence
+// lists of its least occurring variable: a clause D that contains C is
+// removed, and a clause D that contains C except for one negated literal
+// loses that literal.
+
+namespace BVA
+{
+    unsigned AutomatedReencoder::signature(const Clause *c) const
+    {
+        unsigned res = 0;
+        for (int lit : *c)
+            res |= 1u << (vidx(lit) & 31);
+        return res;
+    }
+
+    void AutomatedReencoder::removeSubsumed(Clause *d)
+    {
+        assert(d->active);
+        if (proof)
+            proof->notify_deleted_clause(d->literals());
+        d->active = false; // still referenced by occurrence lists, released at the end
+        cnf.erase(d);
+        to_deallocate.push_back(d);
+    }
+
+    // Replaces d by d \ {lit}, which is a resolvent of d and the current clause.
+    void AutomatedReencoder::strengthen(Clause *d, int lit, vector<Clause *> &schedule)
+    {
+        resolvent.clear();
+        for (int other : *d)
+            if (other != lit)
+                resolvent.push_back(other);
+        Clause *e = arena.allocate(resolvent);
+        if (proof)
+            proof->notify_added_clause(resolvent, false /*learnt*/);
+        removeSubsumed(d);
+        stats.strengthened++;
+        if (find(*e))
+        {
+            if (proof)
+                proof->notify_deleted_clause(resolvent);
+            arena.release(e);
+            return;
+        }
+        e->sig = signature(e);
+        cnf.insert(e);
+        for (int other : *e)
+            occs(other).push_back(e);
+        schedule.push_back(e); // may subsume other clauses now
+    }
+
+    void AutomatedReencoder::subsumeBackward(Clause *c, vector<Clause *> &schedule)
+    {
+        int best = 0;
+        size_t best_occs = SIZE_MAX;
+        for (int lit : *c)
+        {
+            size_t n = occs(lit).size() + occs(-lit).size();
+            if (n < best_occs)
+                best = lit, best_occs = n;
+        }
+        for (int lit : *c)
+            mark(lit);
+        for (int lit : {best, -best})
+        {
+            for (size_t i = 0; i < occs(lit).size(); ++i)
+            {
+                Clause *d = occs(lit)[i];
+                stats.sub_steps++;
+                if (d == c || !d->active || d->size() < c->size() || (c->sig & ~d->sig))
+                    continue;
+                stats.sub_steps += d->size();
+                int found = 0, flipped = 0;
+                for (int other : *d)
+                {
+                    const signed char tmp = marked(other);
+                    if (tmp > 0)
+                        found++;
+                    else if (tmp < 0)
+                    {
+                        if (flipped)
+                        {
+                            flipped = INT_MIN;
+                            break;
+                        }
+                        flipped = other;
+                    }
+                }
+                if (flipped == INT_MIN)
+                    continue;
+                if (!flipped && found == c->size())
+                {
+                    removeSubsumed(d);
+                    stats.subsumed++;
+                }
+                else if (flipped && found == c->size() - 1 && d->size() > 1)
+                    to_strengthen.push_back({d, flipped}); // opposite units are left to the solver
+            }
+        }
+        for (int lit : *c)
+            unmark(lit);
+        // Looking up the strengthened clauses needs the marks
+        for (auto [d, lit] : to_strengthen)
+            strengthen(d, lit, schedule);
+        to_strengthen.clear();
+    }
+
+    void AutomatedReencoder::applySubsumption()
+    {
+        TIME_BLOCK("[PREPROCESSOR] Subsumption");
+        int64_t formula_size;
+        {
+            TIME_BLOCK("[PREPROCESSOR] Building occurrences list");
+            formula_size = connectOccurrences();
+        }
+        vector<Clause *> schedule(cnf.begin(), cnf.end());
+        for (Clause *c : schedule)
+            c->sig = signature(c);
+        // Short clauses subsume more, so they go first
+        stable_sort(schedule.begin(), schedule.end(), [](const Clause *a, const Clause *b)
+                    { return a->size() < b->size(); });
+
+        to_deallocate.clear();
+        const int64_t max_steps = effort > 0 ? stats.sub_steps + (int64_t)(effort * formula_size) : INT64_MAX;
+        const char *limit_reached = nullptr;
+        for (size_t i = 0; i < schedule.size(); ++i)
+        {
+            if (stats.sub_steps > max_steps)
+            {
+                limit_reached = "effort";
+                break;
+            }
+            if (schedule[i]->active)
+                subsumeBackward(schedule[i], schedule);
+        }
+        for (Clause *d : to_deallocate)
+            arena.release(d);
+        to_deallocate.clear();
+
+        if (limit_reached)
+            cout << " -> Reached " << limit_reached << " limit" << endl;
+        else
+            cout << " -> Algorithm ended" << endl;
+
+        cout << "[PREPROCESSOR] Statistics:" << endl;
+        cout << "[PREPROCESSOR]    " << stats.subsumed << " clauses subsumed" << endl;
+        cout << "[PREPROCESSOR]    " << stats.strengthened << " clauses strengthened" << endl;
+        cout << "[PREPROCESSOR]    " << cnf.size() << " clauses remaining" << endl;
+        cout << "[PREPROCESSOR]    " << stats.sub_steps << " steps (" << (formula_size ? (double)stats.sub_steps / formula_size : 0) << " per literal)" << endl;
+
+        if (proof)
+        {
+            proof->notify_comment("    " + to_string(stats.subsumed) + " clauses subsumed");
+            proof->notify_comment("    " + to_string(stats.strengthened) + " clauses strengthened");
+        }
+    }
+};
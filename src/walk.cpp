@@ -0,0 +1,138 @@
+#include "walk.h"
+
+LocalSearch::LocalSearch(unsigned int _nvars, uint64_t seed) :
+	nvars(_nvars), clause_begin(1, 0), occs(2 * _nvars + 1), num_flips(0), rng(seed) {}
+
+void LocalSearch::add_clause(const clause_t &c)
+{
+	const int idx = static_cast<int>(num_clauses());
+	for (Lit l : c)
+	{
+		lits.push_back(l);
+		occs[l].push_back(idx);
+	}
+	clause_begin.push_back(static_cast<int>(lits.size()));
+}
+
+// Cb depends on the average clause length, as in CaDiCaL: the values are the
+// ones found best for uniform random k-SAT, interpolated in between.
+void LocalSearch::init_weights()
+{
+	static const double cb_of_length[] = {2.0, 2.0, 2.0, 2.5, 2.85, 3.7, 5.1, 7.4};
+	const int max_length = sizeof(cb_of_length) / sizeof(cb_of_length[0]) - 1;
+	double length = num_clauses() ? static_cast<double>(lits.size()) / num_clauses() : 0;
+	length = min(length, static_cast<double>(max_length));
+	const int k = min(static_cast<int>(length), max_length - 1);
+	const double cb = cb_of_length[k] + (length - k) * (cb_of_length[k + 1] - cb_of_length[k]);
+	weight.resize(64);
+	for (size_t b = 0; b < weight.size(); ++b)
+		weight[b] = pow(cb, -static_cast<double>(b));
+}
+
+Var LocalSearch::pick(int c)
+{
+	scratch.clear();
+	double sum = 0;
+	for (int i = clause_begin[c]; i < clause_begin[c + 1]; ++i)
+	{
+		const size_t b = static_cast<size_t>(breaks[l2v(lits[i])]);
+		scratch.push_back(weight[min(b, weight.size() - 1)]);
+		sum += scratch.back();
+	}
+	double r = uniform_real_distribution<double>(0, sum)(rng);
+	int i = clause_begin[c];
+	for (double w : scratch)
+	{
+		if (r < w)
+			break;
+		r -= w;
+		++i;
+	}
+	return l2v(lits[min(i, clause_begin[c + 1] - 1)]); // rounding may leave r >= the last weight
+}
+
+void LocalSearch::flip(Var v)
+{
+	value[v] = !value[v];
+	++num_flips;
+	if (!touched[v])
+	{
+		touched[v] = true;
+		changed.push_back(v);
+	}
+	const Lit now_true = v2l(value[v] ? v : -v);
+	for (int c : occs[now_true])
+	{
+		if (num_true[c]++ == 0)
+		{
+			make_sat(c);
+			++breaks[v];
+		}
+		else if (num_true[c] == 2)
+			--breaks[crit[c]];
+		crit[c] ^= v;
+	}
+	for (int c : occs[::negate(now_true)])
+	{
+		crit[c] ^= v;
+		if (--num_true[c] == 0)
+		{
+			make_unsat(c);
+			--breaks[v];
+		}
+		else if (num_true[c] == 1)
+			++breaks[crit[c]];
+	}
+}
+
+int LocalSearch::run(vector<VarState> &phases, int64_t max_flips, const atomic<bool> *stop)
+{
+	const int m = static_cast<int>(num_clauses());
+	init_weights();
+	value.assign(nvars + 1, false);
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		value[v] = phases[v] == VarState::V_TRUE;
+	num_true.assign(m, 0);
+	crit.assign(m, 0);
+	breaks.assign(nvars + 1, 0);
+	unsat.clear();
+	unsat_pos.resize(m);
+	for (int c = 0; c < m; ++c)
+	{
+		for (int i = clause_begin[c]; i < clause_begin[c + 1]; ++i)
+			if (is_true(lits[i]))
+			{
+				++num_true[c];
+				crit[c] ^= l2v(lits[i]);
+			}
+		if (num_true[c] == 0)
+			make_unsat(c);
+		else if (num_true[c] == 1)
+			++breaks[crit[c]];
+	}
+
+	best = value;
+	size_t best_unsat = unsat.size();
+	touched.assign(nvars + 1, false);
+	changed.clear();
+	for (int64_t i = 0; i < max_flips && !unsat.empty(); ++i)
+	{
+		if (stop && (i & 1023) == 0 && stop->load(memory_order_relaxed))
+			break;
+		flip(pick(unsat[rng() % unsat.size()]));
+		if (unsat.size() < best_unsat)
+		{
+			best_unsat = unsat.size();
+			for (Var v : changed)
+			{
+				best[v] = value[v];
+				touched[v] = false;
+			}
+			changed.clear();
+		}
+	}
+
+	for (Var v = 1; v <= static_cast<Var>(nvars); ++v)
+		phases[v] = best[v] ? VarState::V_TRUE : VarState::V_FALSE;
+	return static_cast<int>(best_unsat);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "edusat-header.h"
+#include <atomic>
+
+// ProbSAT local search (Balint and Schöning, SAT 2012). Starting from a full
+// assignment, it repeatedly picks a random unsatisfied clause and flips one of
+// its variables, chosen with probability Cb^-break, where break is the # of
+// clauses that would become unsatisfied. The clauses are copied into one flat
+// array of literals (in the solver's encoding), so a LocalSearch can run on
+// another thread while the solver changes its own clauses.
+class LocalSearch {
+	unsigned int nvars;
+	vector<Lit> lits;		// the literals of all clauses, one clause after the other
+	vector<int> clause_begin; // clause => index into lits of its first literal. The last entry is lits.size()
+	vector<vector<int>> occs; // lit => the clauses containing it
+	vector<int> num_true;	// clause => # of its true literals
+	vector<Var> crit;		// clause => xor of the variables of its true literals: the critical one when num_true is 1
+	vector<int> breaks;		// var => # of clauses in which it is the critical variable
+	vector<int> unsat;		// the unsatisfied clauses, in no particular order
+	vector<int> unsat_pos;	// clause => its index into unsat, if it is unsatisfied
+	vector<bool> value;		// var => current value
+	vector<bool> best;		// var => value in the assignment with the fewest unsatisfied clauses so far
+	vector<bool> touched;	// var => flipped since best was last updated
+	vector<Var> changed;	// the touched variables
+	vector<double> weight;	// break count => Cb^-break
+	vector<double> scratch; // the weights of the literals of the picked clause
+	int64_t num_flips;
+	mt19937_64 rng;
+
+	bool is_true(Lit l) const { return value[l2v(l)] != static_cast<bool>(Neg(l)); }
+	void make_unsat(int c) { unsat_pos[c] = static_cast<int>(unsat.size()); unsat.push_back(c); }
+	void make_sat(int c) { // swaps the last one into its place
+		int last = unsat.back();
+		unsat[unsat_pos[c]] = last;
+		unsat_pos[last] = unsat_pos[c];
+		unsat.pop_back();
+	}
+	void init_weights();
+	Var pick(int c);
+	void flip(Var v);
+
+public:
+	LocalSearch(unsigned int _nvars, uint64_t seed);
+	void add_clause(const clause_t &c);
+	size_t num_clauses() const { return clause_begin.size() - 1; }
+	int64_t flips() const { return num_flips; }
+	// Runs from 'phases' for at most max_flips flips, or until 'stop' is set, and
+	// writes the best assignment found back to 'phases'. Returns its # of
+	// unsatisfied clauses: 0 if it is a model.
+	int run(vector<VarState> &phases, int64_t max_flips, const atomic<bool> *stop = nullptr);
+};
@@ -0,0 +1,87 @@
+#include "watch_pool.h"
+
+static int log2_of(int cap) { return 31 - __builtin_clz(static_cast<unsigned>(cap)); }
+
+void WatchPool::relocate(Head &h, int new_cap)
+{
+	const int cls = log2_of(new_cap);
+	int offset;
+	if (static_cast<int>(free_ranges.size()) > cls && !free_ranges[cls].empty())
+	{
+		offset = free_ranges[cls].back();
+		free_ranges[cls].pop_back();
+		garbage -= new_cap;
+	}
+	else
+	{
+		if (pool.size() + new_cap > pool.capacity())
+		{ // rather than growing a pool that is mostly waste, pack it first
+			if (fragmented())
+				defragment(); // h stays full, in the pool or in its head
+			if (pool.size() + new_cap > pool.capacity())
+				pool.reserve(max(pool.size() + new_cap, pool.capacity() + pool.capacity() / 2));
+		}
+		offset = static_cast<int>(pool.size());
+		pool.resize(pool.size() + new_cap);
+	}
+	int *from = is_inline(h) ? h.inl : pool.data() + h.inl[0];
+	copy(from, from + h.size, pool.data() + offset);
+	if (!is_inline(h))
+	{
+		if (free_ranges.size() < static_cast<size_t>(cls))
+			free_ranges.resize(cls);
+		free_ranges[cls - 1].push_back(h.inl[0]); // h.cap == new_cap / 2
+		garbage += h.cap;
+	}
+	h.cap = new_cap;
+	h.inl[0] = offset;
+}
+
+void WatchPool::clear_all()
+{
+	for (Head &h : heads)
+		h = Head{0, Watch_inline, {}};
+	pool.clear();
+	free_ranges.clear();
+	garbage = entries = 0;
+}
+
+// In place: the lists are moved down in the order of their offsets, each to a
+// range of the smallest power of 2 capacity that holds it, which is not larger
+// than its current one.
+void WatchPool::defragment()
+{
+	vector<pair<int, Lit>> by_offset;
+	for (Lit l = 0; l < static_cast<Lit>(heads.size()); ++l)
+		if (!is_inline(heads[l]))
+			by_offset.push_back({heads[l].inl[0], l});
+	sort(by_offset.begin(), by_offset.end());
+	int top = 0;
+	for (auto [offset, l] : by_offset)
+	{
+		Head &h = heads[l];
+		const int *from = pool.data() + offset;
+		if (h.size <= Watch_inline)
+		{
+			copy(from, from + h.size, h.inl);
+			h.cap = Watch_inline;
+			continue;
+		}
+		copy(from, from + h.size, pool.data() + top); // top <= offset
+		h.cap = 1 << log2_of(2 * h.size - 1);
+		h.inl[0] = top;
+		top += h.cap;
+	}
+	pool.resize(top);
+	free_ranges.clear();
+	garbage = 0;
+}
+
+size_t WatchPool::used_memory() const
+{
+	size_t entries = 0;
+	for (const Head &h : heads)
+		if (!is_inline(h))
+			entries += h.size;
+	return heads.size() * sizeof(Head) + entries * sizeof(int);
+}
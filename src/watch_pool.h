@@ -0,0 +1,64 @@
+#pragma once
+#include "edusat-header.h"
+
+// The watch lists of all literals, in one pool of clause indices instead of a
+// heap block per literal. A list of at most Watch_inline entries is stored in
+// its head. A longer one is a range of the pool, of a power of 2 capacity: when
+// it is full it moves to a range of twice the capacity, and its old range goes
+// to a free list of its capacity, to be reused by the next list that grows to
+// it. defragment() packs the pool again.
+class WatchPool {
+	struct Head {
+		int size;
+		int cap; // <= Watch_inline: the entries are in 'inl'. Otherwise inl[0] is the offset into pool
+		int inl[Watch_inline];
+	};
+	vector<Head> heads;	// lit => its list
+	vector<int> pool;
+	vector<vector<int>> free_ranges; // log2 of capacity => offsets of the free ranges of that capacity
+	size_t garbage;		// # of pool entries in free ranges
+	size_t entries;		// # of entries in all lists
+
+	bool is_inline(const Head &h) const { return h.cap <= Watch_inline; }
+	void relocate(Head &h, int new_cap);
+
+public:
+	// The entries of one list. Invalidated by the next push_back() to any list
+	class List {
+		int *b, *e;
+	public:
+		List(int *_b, int *_e) : b(_b), e(_e) {}
+		int *begin() const { return b; }
+		int *end() const { return e; }
+		int size() const { return static_cast<int>(e - b); }
+		int &operator[](int i) const { return b[i]; }
+	};
+
+	WatchPool() : garbage(0), entries(0) {}
+	void resize(size_t nlits) { heads.resize(nlits + 1, Head{0, Watch_inline, {}}); }
+	size_t num_lists() const { return heads.size(); }
+	int *data(Lit l) { Head &h = heads[l]; return is_inline(h) ? h.inl : pool.data() + h.inl[0]; }
+	int size(Lit l) const { return heads[l].size; }
+	List operator[](Lit l) { int *d = data(l); return List(d, d + heads[l].size); }
+	void push_back(Lit l, int idx) {
+		Head &h = heads[l];
+		if (h.size == h.cap)
+			relocate(h, 2 * h.cap);
+		data(l)[h.size++] = idx;
+		++entries;
+	}
+	void shrink(Lit l, int new_size) { Assert(new_size <= heads[l].size); entries -= heads[l].size - new_size; heads[l].size = new_size; }
+	void clear(Lit l) { shrink(l, 0); }
+	void clear_all(); // empties all lists and frees the pool
+
+	// Packs the lists, each with some room to grow, and moves the short ones
+	// back into their heads.
+	void defragment();
+	// Lists keep their capacity when they shrink, as watches move to other
+	// literals, so the free ranges are only part of the waste.
+	bool fragmented() const { return pool.size() > Watch_pool_min_size && pool.size() > Watch_pool_max_waste * entries; }
+
+	// bytes allocated: heads and pool, and the part of it in use
+	size_t memory() const { return heads.capacity() * sizeof(Head) + pool.capacity() * sizeof(int); }
+	size_t used_memory() const;
+};
@@ -0,0 +1,57 @@
+#include "watch_search.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
+
+int watch_search_scalar(const Lit *lits, int begin, int end, const signed char *vals, Lit skip)
+{
+	for (int i = begin; i < end; ++i)
+		if (vals[lits[i]] >= 0 && lits[i] != skip)
+			return i;
+	return end;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// 8 literals per step: their values are gathered as 32-bit words at byte offsets
+// (the value is the low byte), shifted up so that false values set the sign bit.
+__attribute__((target("avx2")))
+int watch_search_avx2(const Lit *lits, int begin, int end, const signed char *vals, Lit skip)
+{
+	const __m256i skip8 = _mm256_set1_epi32(skip);
+	int i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lits + i));
+		const __m256i v = _mm256_slli_epi32(_mm256_i32gather_epi32(reinterpret_cast<const int *>(vals), l, 1), 24);
+		const unsigned is_false = _mm256_movemask_ps(_mm256_castsi256_ps(v));
+		const unsigned is_skip = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(l, skip8)));
+		const unsigned found = ~(is_false | is_skip) & 0xff;
+		if (found)
+			return i + __builtin_ctz(found);
+	}
+	return watch_search_scalar(lits, i, end, vals, skip);
+}
+#else
+int watch_search_avx2(const Lit *lits, int begin, int end, const signed char *vals, Lit skip)
+{
+	return watch_search_scalar(lits, begin, end, vals, skip);
+}
+#endif
+
+bool has_avx2()
+{
+#ifdef HAVE_AVX2_KERNEL
+	__builtin_cpu_init(); // may run before the constructors that would call it
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+const WatchSearch find_not_false = has_avx2() ? watch_search_avx2 : watch_search_scalar;
+
+const char *watch_search_kernel()
+{
+	return has_avx2() ? "avx2" : "scalar";
+}
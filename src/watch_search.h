@@ -0,0 +1,19 @@
+#pragma once
+#include "edusat-header.h"
+
+// The search for a replacement watch: the first literal of lits[begin, end) that
+// is not false, other than 'skip' (the other watch). 'vals' maps literals to 1 if
+// true, -1 if false and 0 if unassigned, and must be readable Vals_padding bytes
+// past its last literal. Returns end if there is no such literal.
+typedef int (*WatchSearch)(const Lit *lits, int begin, int end, const signed char *vals, Lit skip);
+
+#define Vals_padding 3 // the AVX2 kernel reads 4 bytes per literal
+
+int watch_search_scalar(const Lit *lits, int begin, int end, const signed char *vals, Lit skip);
+int watch_search_avx2(const Lit *lits, int begin, int end, const signed char *vals, Lit skip); // only if the CPU has AVX2
+
+bool has_avx2(); // by CPUID. Also picks the kernels of gauss.h
+
+// The fastest kernel the CPU supports, chosen once at startup by CPUID
+extern const WatchSearch find_not_false;
+const char *watch_search_kernel(); // its name
@@ -10,13 +10,15 @@ fi
 TEST_ROOT=$WORKDIR/tests
 
 # Argments check
-if [ "$#" -lt 1 ] || [ "$#" -gt 2 ]; then
-    echo "Usage: $0 <test_folder> [timeout_in_seconds]"
+if [ "$#" -lt 1 ] || [ "$#" -gt 3 ]; then
+    echo "Usage: $0 <test_folder> [timeout_in_seconds] [edusat_flags]"
     return 1
 fi
 
 TEST_FOLDER=$1
 TIMEOUT_IN_SEC=${2:-3}
+# edusat flags, e.g. "-card 3" or "-pre strash,bve", default to -bva
+FLAGS=${3:--bva}
 
 # Define color codes
 GREEN='\033[0;32m'
@@ -48,7 +50,7 @@ fi
 # Loop through the files safely
 while IFS= read -r TEST_INPUT; do
     NUM_TESTS=$((NUM_TESTS+1))
-    OUTPUT=$(timeout $TIMEOUT_IN_SEC $BINARY -bva $TEST_INPUT)
+    OUTPUT=$(timeout $TIMEOUT_IN_SEC $BINARY $FLAGS $TEST_INPUT)
 
     if [[ $? -eq 124 ]]; then
         echo -e "[${ORANGE}TIMEOUT${NC}] $TEST_INPUT: Timed out after ${TIMEOUT_IN_SEC} seconds."
@@ -10,14 +10,16 @@ fi
 TEST_ROOT=$WORKDIR/tests
 
 # Argments check
-if [ "$#" -lt 1 ] || [ "$#" -gt 2 ]; then
-    echo "Usage: $0 <test_folder> [timeout_in_seconds]"
+if [ "$#" -lt 1 ] || [ "$#" -gt 3 ]; then
+    echo "Usage: $0 <test_folder> [timeout_in_seconds] [edusat_flags]"
     return 1
 fi
 
 TEST_FOLDER=$1
 # Set timeout in seconds, default to 3 if not provided
 TIMEOUT_IN_SEC=${2:-3}
+# edusat flags, e.g. "-card 3" or "-pre strash,bve", default to -bva
+FLAGS=${3:--bva}
 
 # Define color codes
 GREEN='\033[0;32m'
@@ -62,7 +64,8 @@ fi
 # Loop through the files safely
 while IFS= read -r TEST_INPUT; do
     NUM_TESTS=$((NUM_TESTS+1))
-    OUTPUT=$(timeout $TIMEOUT_IN_SEC $BINARY -bva -bva-export $BVA_EXPORT $TEST_INPUT)
+    rm -f $BVA_EXPORT
+    OUTPUT=$(timeout $TIMEOUT_IN_SEC $BINARY $FLAGS -bva-export $BVA_EXPORT $TEST_INPUT)
 
     if [[ $? -eq 124 ]]; then
         echo -e "[${ORANGE}TIMEOUT${NC}] $TEST_INPUT: Timed out after ${TIMEOUT_IN_SEC} seconds."
@@ -77,6 +80,13 @@ while IFS= read -r TEST_INPUT; do
         continue
     fi
 
+    # Without a preprocessing pass nothing is exported, and variables eliminated by bve are
+    # missing from the export but not from the model: then check the model against the input
+    INPUT_VARS=$(grep -m 1 "^p cnf" "$TEST_INPUT" | awk '{print $3}')
+    if [ ! -f "$BVA_EXPORT" ] || [ $(wc -l < "$ASS_FILE") -eq "$INPUT_VARS" ]; then
+        cp "$TEST_INPUT" "$BVA_EXPORT"
+    fi
+
     # In BVA_EXPORT find the line p cnf x y
     LINE=$(grep -m 1 "^p cnf" "$BVA_EXPORT")
     VARS=$(echo "$LINE" | awk '{print $3}')